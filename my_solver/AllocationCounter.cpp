@@ -0,0 +1,33 @@
+#include "pch.h"
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+std::atomic<bool> allocation_counting(false);
+
+static std::atomic<std::uint64_t> allocation_count(0);
+
+std::uint64_t get_allocation_count()
+{
+	return allocation_count.load(std::memory_order_relaxed);
+}
+
+//the array and nothrow versions of the standard library forward to these two
+void* operator new(const std::size_t size)
+{
+	if (allocation_counting.load(std::memory_order_relaxed)) allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+	while (true)
+	{
+		if (auto memory = std::malloc(size ? size : 1)) return memory;
+
+		auto handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
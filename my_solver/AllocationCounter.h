@@ -0,0 +1,10 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+//the global operator new is replaced in AllocationCounter.cpp to count the heap allocations of the process,
+//so benchmarks can show which steps still allocate
+//counting is off until allocation_counting is set, until then an allocation only checks the flag
+extern std::atomic<bool> allocation_counting;
+
+std::uint64_t get_allocation_count();
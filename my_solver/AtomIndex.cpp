@@ -0,0 +1,277 @@
+#include "pch.h"
+#include "AtomIndex.h"
+#include "Checkpoint.h"
+#include <algorithm>
+#include <cmath>
+
+//distance of (x, y) along the hilbert curve filling a side x side square, side has to be a power of two
+//see https://en.wikipedia.org/wiki/Hilbert_curve
+static std::uint64_t hilbert_distance(const std::uint64_t side, std::uint64_t x, std::uint64_t y)
+{
+	std::uint64_t distance = 0;
+	for (auto s = side / 2; s > 0; s /= 2)
+	{
+		const std::uint64_t rx = (x & s) > 0;
+		const std::uint64_t ry = (y & s) > 0;
+		distance += s * s * ((3 * rx) ^ ry);
+
+		//rotate the quadrant
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = side - 1 - x;
+				y = side - 1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return distance;
+}
+
+AtomIndex::AtomIndex() = default;
+
+void AtomIndex::init(const int size, const AtomOrdering ordering)
+{
+	//the ranks only depend on the size and the ordering, a reused index keeps them
+	const auto same_cells = size == mSize && ordering == mOrdering && mCell_rank.size() == std::size_t(size) * size;
+
+	mSize = size;
+	mWords_per_unit = (size + 63) / 64;
+	mOrdering = ordering;
+
+	if (!same_cells) init_cell_ranks();
+
+	mMasks.assign(std::size_t(size) * size * mWords_per_unit, 0);
+	mWord_offsets.clear();
+	mAtom_x.clear();
+	mAtom_y.clear();
+	mAtom_n.clear();
+}
+
+void AtomIndex::init_cell_ranks()
+{
+	const auto cells = std::size_t(mSize) * mSize;
+	mCell_order.resize(cells);
+	mCell_rank.resize(cells);
+
+	for (std::size_t cell = 0; cell < cells; ++cell) mCell_order[cell] = cell;
+
+	if (mOrdering == AtomOrdering::box_major)
+	{
+		const auto n = int(std::sqrt(mSize));
+		std::stable_sort(mCell_order.begin(), mCell_order.end(), [&](const std::uint32_t a, const std::uint32_t b) {
+			const auto box_a = (a / mSize / n) * n + (a % mSize) / n;
+			const auto box_b = (b / mSize / n) * n + (b % mSize) / n;
+			return box_a < box_b;
+		});
+	}
+	else if (mOrdering == AtomOrdering::curve)
+	{
+		std::uint64_t side = 1;
+		while (side < std::uint64_t(mSize)) side *= 2;
+
+		std::vector<std::uint64_t> distance(cells);
+		for (std::size_t cell = 0; cell < cells; ++cell)
+			distance[cell] = hilbert_distance(side, cell % mSize, cell / mSize);
+
+		std::sort(mCell_order.begin(), mCell_order.end(), [&](const std::uint32_t a, const std::uint32_t b) {
+			return distance[a] < distance[b];
+		});
+	}
+
+	for (std::size_t rank = 0; rank < cells; ++rank) mCell_rank[mCell_order[rank]] = rank;
+}
+
+void AtomIndex::add(const int x, const int y, const int n)
+{
+	mMasks[word_index(x, y, n)] |= std::uint64_t(1) << (bit_index(x, n) % 64);
+}
+
+void AtomIndex::add_cell(const int x, const int y, const std::uint64_t* words)
+{
+	if (!is_cell_based())
+	{
+		//the numbers of one cell are spread over several units
+		for (auto w = 0; w < mWords_per_unit; ++w) {
+			auto mask = words[w];
+			while (mask)
+			{
+				add(x, y, w * 64 + __builtin_ctzll(mask));
+				mask &= mask - 1;		//clear lowest set bit
+			}
+		}
+		return;
+	}
+
+	const auto unit = std::size_t(mCell_rank[std::size_t(y) * mSize + x]) * mWords_per_unit;
+	for (auto w = 0; w < mWords_per_unit; ++w) mMasks[unit + w] |= words[w];
+}
+
+void AtomIndex::finalize()
+{
+	mWord_offsets.resize(mMasks.size());
+
+	//prefix sums over the popcounts of all words
+	std::uint32_t counter = 0;
+	for (std::size_t i = 0; i < mMasks.size(); ++i)
+	{
+		mWord_offsets[i] = counter;
+		counter += __builtin_popcountll(mMasks[i]);
+	}
+
+	//fill the reverse table in atom order
+	mAtom_x.resize(counter);
+	mAtom_y.resize(counter);
+	mAtom_n.resize(counter);
+
+	std::size_t atom = 0;
+	const auto units = std::size_t(mSize) * mSize;
+	for (std::size_t unit = 0; unit < units; ++unit) {
+		for (auto w = 0; w < mWords_per_unit; ++w) {
+			auto mask = mMasks[unit * mWords_per_unit + w];
+			while (mask)
+			{
+				const auto bit = w * 64 + __builtin_ctzll(mask);
+				if (is_cell_based())
+				{
+					mAtom_x[atom] = mCell_order[unit] % mSize;
+					mAtom_y[atom] = mCell_order[unit] / mSize;
+					mAtom_n[atom] = bit;
+				}
+				else
+				{
+					mAtom_x[atom] = bit;
+					mAtom_y[atom] = unit % mSize;
+					mAtom_n[atom] = unit / mSize;
+				}
+				++atom;
+				mask &= mask - 1;		//clear lowest set bit
+			}
+		}
+	}
+}
+
+void AtomIndex::get_position(const int atom, int* x, int* y, int* n) const
+{
+	*x = mAtom_x[atom - 1];
+	*y = mAtom_y[atom - 1];
+	*n = mAtom_n[atom - 1];
+}
+
+bool AtomIndex::contains(const int x, const int y, const int n) const
+{
+	return (mMasks[word_index(x, y, n)] >> (bit_index(x, n) % 64)) & 1;
+}
+
+bool AtomIndex::contains_cell(const int x, const int y, const std::uint64_t* words) const
+{
+	for (auto w = 0; w < mWords_per_unit; ++w)
+	{
+		auto mask = words[w];
+		while (mask)
+		{
+			const auto n = w * 64 + __builtin_ctzll(mask);
+			if (n >= mSize || !contains(x, y, n)) return false;
+			mask &= mask - 1;
+		}
+	}
+	return true;
+}
+
+int AtomIndex::get_number_of_atoms() const
+{
+	return int(mAtom_n.size());
+}
+
+AtomOrdering AtomIndex::get_ordering() const
+{
+	return mOrdering;
+}
+
+std::size_t AtomIndex::get_lookup_bytes() const
+{
+	return (mCell_rank.capacity() + mCell_order.capacity() + mWord_offsets.capacity()) * sizeof(std::uint32_t)
+		 + mMasks.capacity() * sizeof(std::uint64_t);
+}
+
+std::size_t AtomIndex::get_reverse_bytes() const
+{
+	return (mAtom_x.capacity() + mAtom_y.capacity() + mAtom_n.capacity()) * sizeof(std::uint16_t);
+}
+
+bool parse_atom_ordering(const std::string& name, AtomOrdering* ordering)
+{
+	if (name == "cell") *ordering = AtomOrdering::cell_major;
+	else if (name == "digit") *ordering = AtomOrdering::digit_major;
+	else if (name == "box") *ordering = AtomOrdering::box_major;
+	else if (name == "curve") *ordering = AtomOrdering::curve;
+	else return false;
+	return true;
+}
+
+const char* get_atom_ordering_name(const AtomOrdering ordering)
+{
+	switch (ordering)
+	{
+	case AtomOrdering::digit_major: return "digit";
+	case AtomOrdering::box_major: return "box";
+	case AtomOrdering::curve: return "curve";
+	default: return "cell";
+	}
+}
+
+void AtomIndex::write_checkpoint(CheckpointWriter* checkpoint) const
+{
+	checkpoint->write_value(mSize);
+	checkpoint->write_value(std::uint64_t(mOrdering));
+	checkpoint->write_array(mCell_rank);
+	checkpoint->write_array(mCell_order);
+	checkpoint->write_array(mMasks);
+	checkpoint->write_array(mWord_offsets);
+	checkpoint->write_array(mAtom_x);
+	checkpoint->write_array(mAtom_y);
+	checkpoint->write_array(mAtom_n);
+}
+
+bool AtomIndex::read_checkpoint(CheckpointReader* checkpoint, const int size)
+{
+	std::uint64_t stored_size, ordering;
+	if (!checkpoint->read_value(&stored_size) || stored_size != std::uint64_t(size)
+		|| !checkpoint->read_value(&ordering) || ordering > std::uint64_t(AtomOrdering::curve))
+		return false;
+
+	mSize = size;
+	mWords_per_unit = (mSize + 63) / 64;
+	mOrdering = AtomOrdering(ordering);
+
+	const auto units = std::size_t(mSize) * mSize;
+	if (!checkpoint->read_array(&mCell_rank) || !checkpoint->read_array(&mCell_order) || !checkpoint->read_array(&mMasks)
+		|| !checkpoint->read_array(&mWord_offsets) || !checkpoint->read_array(&mAtom_x) || !checkpoint->read_array(&mAtom_y)
+		|| !checkpoint->read_array(&mAtom_n)
+		|| mCell_rank.size() != units || mCell_order.size() != units || mMasks.size() != units * mWords_per_unit
+		|| mWord_offsets.size() != mMasks.size() || mAtom_y.size() != mAtom_x.size() || mAtom_n.size() != mAtom_x.size())
+		return false;
+
+	//the ranks have to be a permutation with the order as its inverse
+	for (std::size_t cell = 0; cell < units; ++cell)
+		if (mCell_rank[cell] >= units || mCell_order[mCell_rank[cell]] != cell) return false;
+
+	//the offsets are the prefix sums of the masks and end at the number of atoms
+	std::uint64_t atoms = 0;
+	for (std::size_t word = 0; word < mMasks.size(); ++word)
+	{
+		if (mWord_offsets[word] != atoms) return false;
+		atoms += __builtin_popcountll(mMasks[word]);
+	}
+	if (atoms != mAtom_x.size()) return false;
+
+	//every atom lies inside the sudoku and is the candidate the masks number with it
+	for (std::size_t atom = 0; atom < mAtom_x.size(); ++atom)
+	{
+		if (mAtom_x[atom] >= mSize || mAtom_y[atom] >= mSize || mAtom_n[atom] >= mSize
+			|| get_atom(mAtom_x[atom], mAtom_y[atom], mAtom_n[atom]) != int(atom) + 1)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <string>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+//order in which the atoms of the surviving candidates are numbered
+enum class AtomOrdering
+{
+	cell_major,		//y, x, n - the original numbering
+	digit_major,	//n, y, x
+	box_major,		//box by box, inside a box y, x, then n
+	curve			//cells along a hilbert curve, then n
+};
+
+//compact replacement for the dense lookup tables
+//maps (x, y, n) of every surviving candidate to a consecutive atom number and back in O(1)
+//the candidates are stored as bitmasks over units of size bits, a unit is a cell (bits are the numbers)
+//or for the digit major ordering a row of one number (bits are the x coordinates)
+//atoms are numbered unit by unit in the order given by the ordering, inside a unit by ascending bit
+class AtomIndex
+{
+public:
+	AtomIndex();
+
+	//drops all entries and prepares the index for a sudoku of the given size, keeps the buffers if the size stays the same
+	void init(int size, AtomOrdering ordering = AtomOrdering::cell_major);
+
+	//marks (x, y, n) as a surviving candidate, only valid before finalize()
+	void add(int x, int y, int n);
+
+	//copies the candidate words of a whole cell at once, words holds (size + 63) / 64 words
+	void add_cell(int x, int y, const std::uint64_t* words);
+
+	//computes the prefix sums and the reverse table, has to be called once after all add() calls
+	void finalize();
+
+	//returns the atom number of (x, y, n), or 0 if it is not a candidate
+	int get_atom(int x, int y, int n) const
+	{
+		const auto word = word_index(x, y, n);
+		const auto bit = std::uint64_t(1) << (bit_index(x, n) % 64);
+		if (!(mMasks[word] & bit)) return 0;
+
+		return mWord_offsets[word] + __builtin_popcountll(mMasks[word] & (bit - 1)) + 1;	//+1 so 0 is impossible
+	}
+
+	//returns the position of an atom, atom has to be in [1, get_number_of_atoms()]
+	void get_position(int atom, int* x, int* y, int* n) const;
+
+	bool contains(int x, int y, int n) const;
+
+	//true if every number set in the words of the cell is a candidate of the index, words as for add_cell()
+	bool contains_cell(int x, int y, const std::uint64_t* words) const;
+
+	int get_number_of_atoms() const;
+
+	AtomOrdering get_ordering() const;
+
+	//bytes held by the direction from candidates to atoms (cell ranks, masks and their prefix sums) and by the reverse one
+	std::size_t get_lookup_bytes() const;
+	std::size_t get_reverse_bytes() const;
+
+	//stores the finalized index in a checkpoint and reads it back, read_checkpoint() returns false if the data doesn't fit
+	//a finalized index of a sudoku of the given size, every rank, offset and atom is checked since the file could be damaged
+	void write_checkpoint(CheckpointWriter* checkpoint) const;
+	bool read_checkpoint(CheckpointReader* checkpoint, int size);
+
+private:
+	bool is_cell_based() const { return mOrdering != AtomOrdering::digit_major; }
+
+	std::size_t unit_index(int x, int y, int n) const
+	{
+		return is_cell_based() ? mCell_rank[std::size_t(y) * mSize + x] : std::size_t(n) * mSize + y;
+	}
+
+	int bit_index(int x, int n) const
+	{
+		return is_cell_based() ? n : x;
+	}
+
+	std::size_t word_index(int x, int y, int n) const
+	{
+		return unit_index(x, y, n) * mWords_per_unit + bit_index(x, n) / 64;
+	}
+
+	//computes the rank of every cell for the cell based orderings
+	void init_cell_ranks();
+
+	int mSize = 0;
+	int mWords_per_unit = 0;
+	AtomOrdering mOrdering = AtomOrdering::cell_major;
+
+	//position of every cell (index y * size + x) in the numbering, and the cells in numbering order
+	std::vector<std::uint32_t> mCell_rank;
+	std::vector<std::uint32_t> mCell_order;
+
+	//candidate bitmask, mWords_per_unit words for every unit, units are stored in numbering order
+	std::vector<std::uint64_t> mMasks;
+
+	//number of atoms in front of every mask word, the popcount prefix sum over mMasks
+	std::vector<std::uint32_t> mWord_offsets;
+
+	//the reverse direction, one entry per atom
+	std::vector<std::uint16_t> mAtom_x;
+	std::vector<std::uint16_t> mAtom_y;
+	std::vector<std::uint16_t> mAtom_n;
+};
+
+//parses the name of an ordering as used on the commandline, returns false if it is unknown
+bool parse_atom_ordering(const std::string& name, AtomOrdering* ordering);
+const char* get_atom_ordering_name(AtomOrdering ordering);
@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+//queue between two stages of the pipeline, push blocks while it is full and pop while it is empty
+//it records how long both sides were blocked and how full it was, so the slow stage can be found
+template <typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(const std::size_t capacity) : mCapacity(capacity > 0 ? capacity : 1)
+	{
+	}
+
+	void push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		const auto wait_start = std::chrono::steady_clock::now();
+		mNot_full.wait(lock, [this]() { return mItems.size() < mCapacity; });
+		mPush_wait += std::chrono::steady_clock::now() - wait_start;
+
+		mItems.push_back(std::move(item));
+		mOccupancy_sum += mItems.size();
+		++mPushes;
+
+		mNot_empty.notify_one();
+	}
+
+	//returns false once the queue is closed and nothing is left
+	bool pop(T* item)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		const auto wait_start = std::chrono::steady_clock::now();
+		mNot_empty.wait(lock, [this]() { return !mItems.empty() || mClosed; });
+		mPop_wait += std::chrono::steady_clock::now() - wait_start;
+
+		if (mItems.empty()) return false;
+
+		*item = std::move(mItems.front());
+		mItems.pop_front();
+
+		mNot_full.notify_one();
+		return true;
+	}
+
+	//the producer is done, wakes up every consumer waiting on the empty queue
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mClosed = true;
+		mNot_empty.notify_all();
+	}
+
+	std::size_t get_capacity() const { return mCapacity; }
+
+	//seconds the producers waited for space and the consumers waited for items
+	double get_push_wait_seconds() const { return std::chrono::duration<double>(mPush_wait).count(); }
+	double get_pop_wait_seconds() const { return std::chrono::duration<double>(mPop_wait).count(); }
+
+	//average amount of items in the queue right after a push
+	double get_average_occupancy() const { return mPushes ? double(mOccupancy_sum) / mPushes : 0.; }
+
+private:
+	std::size_t mCapacity;
+	bool mClosed = false;
+
+	std::deque<T> mItems;
+	std::mutex mMutex;
+	std::condition_variable mNot_full;
+	std::condition_variable mNot_empty;
+
+	std::chrono::steady_clock::duration mPush_wait{0};
+	std::chrono::steady_clock::duration mPop_wait{0};
+	std::size_t mOccupancy_sum = 0;
+	std::size_t mPushes = 0;
+};
@@ -0,0 +1,77 @@
+#include "pch.h"
+#include "CandidateMatrix.h"
+#include "Checkpoint.h"
+#include <algorithm>
+
+void CandidateMatrix::init(const int size)
+{
+	mSize = size;
+	mWords_per_cell = (size + 63) / 64;
+
+	const auto remaining_bits = size % 64;
+	mLast_word_mask = remaining_bits ? (std::uint64_t(1) << remaining_bits) - 1 : ~std::uint64_t(0);
+
+	mWords.resize(std::size_t(size) * size * mWords_per_cell);
+	fill();
+}
+
+void CandidateMatrix::fill()
+{
+	for (std::size_t i = 0; i < mWords.size(); ++i)
+	{
+		//only the bits of actual numbers are set, so popcounts stay correct
+		mWords[i] = (i % mWords_per_cell == std::size_t(mWords_per_cell - 1)) ? mLast_word_mask : ~std::uint64_t(0);
+	}
+}
+
+void CandidateMatrix::set_only(const int x, const int y, const int n)
+{
+	auto cell = get_cell(x, y);
+	for (auto w = 0; w < mWords_per_cell; ++w) cell[w] = 0;
+	cell[n / 64] = std::uint64_t(1) << (n % 64);
+}
+
+int CandidateMatrix::count(const int x, const int y) const
+{
+	auto cell = get_cell(x, y);
+	auto result = 0;
+	for (auto w = 0; w < mWords_per_cell; ++w) result += __builtin_popcountll(cell[w]);
+	return result;
+}
+
+int CandidateMatrix::get_single(const int x, const int y) const
+{
+	auto cell = get_cell(x, y);
+	auto result = -2;
+	for (auto w = 0; w < mWords_per_cell; ++w)
+	{
+		if (!cell[w]) continue;
+		if (result != -2 || (cell[w] & (cell[w] - 1))) return -1;	//more than one bit set
+		result = w * 64 + __builtin_ctzll(cell[w]);
+	}
+	return result;
+}
+
+bool CandidateMatrix::same_numbers(const int x1, const int y1, const int x2, const int y2) const
+{
+	auto cell1 = get_cell(x1, y1);
+	auto cell2 = get_cell(x2, y2);
+	for (auto w = 0; w < mWords_per_cell; ++w)
+		if (cell1[w] != cell2[w]) return false;
+	return true;
+}
+
+void CandidateMatrix::write_checkpoint(CheckpointWriter* checkpoint) const
+{
+	checkpoint->write_array(mWords);
+}
+
+bool CandidateMatrix::read_checkpoint(CheckpointReader* checkpoint)
+{
+	std::size_t count;
+	const auto words = checkpoint->read_array<std::uint64_t>(&count);
+	if (!words || count != mWords.size()) return false;
+
+	std::copy(words, words + count, mWords.begin());
+	return true;
+}
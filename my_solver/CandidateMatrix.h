@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+//bit packed store of the candidates of every cell, replaces the nested vector<vector<vector<bool>>>
+//every cell owns get_words_per_cell() consecutive 64 bit words, cells are stored in x, y order
+//the accessors are inline since the preprocessing and the encoder call them in their innermost loops
+class CandidateMatrix
+{
+public:
+	//resizes the matrix for a sudoku of the given size and marks every number as possible
+	void init(int size);
+
+	//marks every number as possible again, keeps the size
+	void fill();
+
+	bool get(int x, int y, int n) const
+	{
+		return (mWords[word_index(x, y, n)] >> (n % 64)) & 1;
+	}
+
+	//same as above, cell is the index x * size + y
+	bool get(std::size_t cell, int n) const
+	{
+		return (mWords[cell * mWords_per_cell + n / 64] >> (n % 64)) & 1;
+	}
+
+	void set(int x, int y, int n)
+	{
+		mWords[word_index(x, y, n)] |= std::uint64_t(1) << (n % 64);
+	}
+
+	//removes n from the cell, returns true if it was possible before
+	bool clear(int x, int y, int n)
+	{
+		auto& word = mWords[word_index(x, y, n)];
+		const auto bit = std::uint64_t(1) << (n % 64);
+		const bool was_set = (word & bit) != 0;
+		word &= ~bit;
+		return was_set;
+	}
+
+	//leaves n as the only possible number in the cell
+	void set_only(int x, int y, int n);
+
+	//returns the amount of numbers still possible in the cell
+	int count(int x, int y) const;
+
+	//returns the number if exactly one is left, -1 if there are multiple and -2 if there is none
+	int get_single(int x, int y) const;
+
+	//returns true if both cells have exactly the same numbers left
+	bool same_numbers(int x1, int y1, int x2, int y2) const;
+
+	const std::uint64_t* get_cell(int x, int y) const
+	{
+		return &mWords[(std::size_t(x) * mSize + y) * mWords_per_cell];
+	}
+
+	std::uint64_t* get_cell(int x, int y)
+	{
+		return &mWords[(std::size_t(x) * mSize + y) * mWords_per_cell];
+	}
+
+	int get_words_per_cell() const { return mWords_per_cell; }
+
+	//stores the candidates in a checkpoint and reads them back into a matrix of the same size, returns false if they don't fit
+	void write_checkpoint(CheckpointWriter* checkpoint) const;
+	bool read_checkpoint(CheckpointReader* checkpoint);
+
+	//bytes held by the candidate words
+	std::size_t get_bytes() const { return mWords.capacity() * sizeof(std::uint64_t); }
+
+private:
+	std::size_t word_index(int x, int y, int n) const
+	{
+		return (std::size_t(x) * mSize + y) * mWords_per_cell + n / 64;
+	}
+
+	int mSize = 0;
+	int mWords_per_cell = 0;
+
+	//mask of the valid bits in the last word of every cell
+	std::uint64_t mLast_word_mask = 0;
+
+	std::vector<std::uint64_t> mWords;
+};
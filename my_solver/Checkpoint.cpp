@@ -0,0 +1,61 @@
+#include "pch.h"
+#include "Checkpoint.h"
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool get_file_stamp(const std::string& path, std::uint64_t* size, std::uint64_t* modified)
+{
+	struct stat status;
+	if (stat(path.c_str(), &status) == -1) return false;
+
+	*size = std::uint64_t(status.st_size);
+	*modified = std::uint64_t(status.st_mtim.tv_sec) * 1000000000 + std::uint64_t(status.st_mtim.tv_nsec);
+	return true;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path) :
+	mPath(path), mTemp_path(path + "." + std::to_string(getpid()) + ".tmp"), mFile(mTemp_path, std::ios::binary)
+{
+}
+
+void CheckpointWriter::write_value(const std::uint64_t value)
+{
+	mFile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void CheckpointWriter::write_bytes(const void* data, const std::size_t bytes)
+{
+	static const char padding[8] = {};
+
+	mFile.write(static_cast<const char*>(data), bytes);
+	if (bytes % 8) mFile.write(padding, 8 - bytes % 8);
+}
+
+bool CheckpointWriter::finish()
+{
+	mFile.close();
+	if (!mFile.fail() && std::rename(mTemp_path.c_str(), mPath.c_str()) == 0) return true;
+
+	std::remove(mTemp_path.c_str());
+	return false;
+}
+
+CheckpointReader::CheckpointReader(const std::string& path) : mFile(path)
+{
+}
+
+//an empty checkpoint is as useless as a missing one
+bool CheckpointReader::is_open() const
+{
+	return mFile.data() != nullptr;
+}
+
+bool CheckpointReader::read_value(std::uint64_t* value)
+{
+	if (!mFile.data() || mFile.size() - mPosition < sizeof(*value)) return false;
+
+	*value = *reinterpret_cast<const std::uint64_t*>(mFile.data() + mPosition);
+	mPosition += sizeof(*value);
+	return true;
+}
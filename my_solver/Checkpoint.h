@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+//binary snapshots of the preprocessed sudoku, see Sudoku::write_checkpoint()
+//a file is a list of 64 bit values and arrays, an array is its element count followed by the elements padded to 8 bytes,
+//so every array is aligned in the mapped file and can be copied out of it in one go
+
+//size and modification time of a file, a checkpoint is only used while the sudoku it was made of is unchanged
+bool get_file_stamp(const std::string& path, std::uint64_t* size, std::uint64_t* modified);
+
+//writes to a temporary file that replaces path in finish(), so nobody ever maps a half written checkpoint
+class CheckpointWriter
+{
+public:
+	explicit CheckpointWriter(const std::string& path);
+
+	void write_value(std::uint64_t value);
+
+	template <typename T>
+	void write_array(const T* data, const std::size_t count)
+	{
+		write_value(count);
+		write_bytes(data, count * sizeof(T));
+	}
+
+	template <typename T>
+	void write_array(const std::vector<T>& values)
+	{
+		write_array(values.data(), values.size());
+	}
+
+	//returns false if anything couldn't be written, the checkpoint is dropped then
+	bool finish();
+
+private:
+	void write_bytes(const void* data, std::size_t bytes);
+
+	std::string mPath;
+	std::string mTemp_path;
+	std::ofstream mFile;
+};
+
+//maps a checkpoint and reads it in the order it was written, every read fails once the file ends early
+class CheckpointReader
+{
+public:
+	explicit CheckpointReader(const std::string& path);
+
+	bool is_open() const;
+
+	bool read_value(std::uint64_t* value);
+
+	//points into the mapping, count receives the amount of elements, returns nullptr if the file ends early
+	template <typename T>
+	const T* read_array(std::size_t* count)
+	{
+		std::uint64_t elements;
+		if (!read_value(&elements) || elements > (mFile.size() - mPosition) / sizeof(T)) return nullptr;
+
+		const auto data = reinterpret_cast<const T*>(mFile.data() + mPosition);
+		mPosition += (elements * sizeof(T) + 7) / 8 * 8;
+		if (mPosition > mFile.size()) return nullptr;
+
+		*count = elements;
+		return data;
+	}
+
+	template <typename T>
+	bool read_array(std::vector<T>* values)
+	{
+		std::size_t count;
+		const auto data = read_array<T>(&count);
+		if (!data) return false;
+		values->assign(data, data + count);
+		return true;
+	}
+
+private:
+	MappedFile mFile;
+	std::size_t mPosition = 0;
+};
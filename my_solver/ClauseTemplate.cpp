@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "ClauseTemplate.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cmath>
+
+const ClauseTemplate& ClauseTemplate::get(const int size, const int commander_encoding_size)
+{
+	static std::mutex templates_mutex;
+	static std::map<std::pair<int, int>, std::unique_ptr<ClauseTemplate>> templates;
+
+	std::lock_guard<std::mutex> lock(templates_mutex);
+
+	auto& entry = templates[{size, commander_encoding_size}];
+	if (!entry) entry.reset(new ClauseTemplate(size, commander_encoding_size));
+
+	return *entry;
+}
+
+ClauseTemplate::ClauseTemplate(const int size, const int commander_encoding_size) :
+	mSize(size), mN(int(std::sqrt(size))), mCommander_group_size(commander_encoding_size)
+{
+	mUnit_cells.resize(std::size_t(3) * size * size);
+
+	for (auto unit = 0; unit < size; ++unit)
+	{
+		auto row = &mUnit_cells[(std::size_t(UnitType::row) * size + unit) * size];
+		auto column = &mUnit_cells[(std::size_t(UnitType::column) * size + unit) * size];
+		auto section = &mUnit_cells[(std::size_t(UnitType::section) * size + unit) * size];
+
+		for (auto i = 0; i < size; ++i)
+		{
+			row[i] = std::uint32_t(i) * size + unit;
+			column[i] = std::uint32_t(unit) * size + i;
+		}
+
+		//sections list their cells column by column, like the nested loops in the encoder did
+		const auto section_x = unit / mN;
+		const auto section_y = unit % mN;
+		auto i = 0;
+		for (auto x_i = section_x * mN; x_i < (section_x + 1) * mN; ++x_i)
+			for (auto y_i = section_y * mN; y_i < (section_y + 1) * mN; ++y_i)
+				section[i++] = std::uint32_t(x_i) * size + y_i;
+	}
+
+	mCommander_levels.resize(size + 1);
+
+	//groups of up to the group size get one commander each, the commanders form the next level
+	if (mCommander_group_size > 1)
+	{
+		for (auto count = 0; count <= size; ++count)
+		{
+			for (auto level = count; level > 1; level = (level + mCommander_group_size - 1) / mCommander_group_size)
+				mCommander_levels[count].push_back(level);
+		}
+	}
+}
+
+int ClauseTemplate::get_commander_group_size() const
+{
+	return mCommander_group_size;
+}
+
+std::size_t ClauseTemplate::get_bytes() const
+{
+	auto bytes = mUnit_cells.capacity() * sizeof(std::uint32_t) + mCommander_levels.capacity() * sizeof(std::vector<int>);
+	for (const auto& levels : mCommander_levels) bytes += levels.capacity() * sizeof(int);
+	return bytes;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+enum class UnitType
+{
+	row,
+	column,
+	section
+};
+
+//the structure of the clauses for one sudoku size, it is the same for every puzzle of that size
+//holds which cells belong to which unit and how the commander encoding splits a group of a given length,
+//so the encoder only has to apply the candidates of a puzzle to it
+//templates are immutable once built and shared by all sudokus of the same size
+class ClauseTemplate
+{
+public:
+	//returns the template for the given size and commander group size, builds it on first use
+	static const ClauseTemplate& get(int size, int commander_encoding_size);
+
+	ClauseTemplate(int size, int commander_encoding_size);
+
+	//the size cells of a unit as index x * size + y, in the order the clauses list them
+	//rows and columns are numbered by their coordinate, sections by section_x * n + section_y
+	const std::uint32_t* get_unit_cells(UnitType type, int unit) const
+	{
+		return &mUnit_cells[(std::size_t(type) * mSize + unit) * mSize];
+	}
+
+	//amount of variables on every level of the commander encoding of a group with count variables
+	//the first level is the group itself, a level with one variable or less ends the encoding and isn't listed
+	const std::vector<int>& get_commander_levels(int count) const
+	{
+		return mCommander_levels[count];
+	}
+
+	int get_commander_group_size() const;
+
+	//bytes held by the unit cells and the commander levels
+	std::size_t get_bytes() const;
+
+private:
+	int mSize;
+	int mN;
+	int mCommander_group_size;
+
+	std::vector<std::uint32_t> mUnit_cells;
+
+	//indexed by the length of the group, there are never more than size variables in one group
+	std::vector<std::vector<int>> mCommander_levels;
+};
@@ -0,0 +1,268 @@
+#include "pch.h"
+#include "Corpus.h"
+#include "SudokuParser.h"
+#include <cmath>
+#include <cstring>
+
+static const char CORPUS_MAGIC[8] = {'S', 'U', 'D', 'O', 'C', 'O', 'R', '1'};
+const std::size_t CORPUS_HEADER_BYTES = 24;
+const std::size_t RECORD_HEADER_BYTES = 8;
+const std::size_t WRITE_BLOCK_BYTES = 1 << 20;
+
+//4 bits hold the numbers up to 15, 8 bits up to 255
+static int get_cell_bits(const int size)
+{
+	return size < 16 ? 4 : size < 256 ? 8 : 16;
+}
+
+static std::size_t get_record_bytes(const int size)
+{
+	return RECORD_HEADER_BYTES + (std::size_t(size) * size * get_cell_bits(size) + 7) / 8;
+}
+
+static std::uint64_t read_u64(const char* data)
+{
+	std::uint64_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static std::uint32_t read_u32(const char* data)
+{
+	std::uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static void append_bytes(std::string* buffer, const void* data, const std::size_t bytes)
+{
+	buffer->append(static_cast<const char*>(data), bytes);
+}
+
+static const char* find_line_end(const char* position, const char* end)
+{
+	const auto newline = static_cast<const char*>(std::memchr(position, '\n', std::size_t(end - position)));
+	return newline ? newline : end;
+}
+
+CorpusReader::CorpusReader(const std::string& path) : mFile(path)
+{
+	if (!mFile.is_open()) return;
+
+	mPosition = mFile.data();
+	mEnd = mFile.data() + mFile.size();
+	mOpen = true;
+
+	const auto size = mFile.size();
+	if (size >= CORPUS_HEADER_BYTES && std::memcmp(mPosition, CORPUS_MAGIC, sizeof(CORPUS_MAGIC)) == 0)
+	{
+		mFormat = CorpusFormat::binary;
+		mCount = read_u64(mPosition + 8);
+		const auto index_offset = read_u64(mPosition + 16);
+
+		//the index has to fit, the records are checked when they are read
+		if (index_offset > size || mCount > (size - index_offset) / sizeof(std::uint64_t))
+		{
+			mOpen = false;
+			return;
+		}
+		mIndex = mPosition + index_offset;
+	}
+	else if ((size >= 11 && std::memcmp(mPosition, "experiment:", 11) == 0) || (size > 0 && *mPosition == '+'))
+	{
+		mFormat = CorpusFormat::table;
+	}
+}
+
+bool CorpusReader::is_open() const
+{
+	return mOpen;
+}
+
+CorpusFormat CorpusReader::get_format() const
+{
+	return mFormat;
+}
+
+std::size_t CorpusReader::get_bytes() const
+{
+	return mFile.size();
+}
+
+bool CorpusReader::next(std::vector<int>* cells, int* size, RecordStatus* status)
+{
+	if (!mOpen) return false;
+
+	if (mFormat == CorpusFormat::binary) return next_binary(cells, size, status);
+
+	if (mFormat == CorpusFormat::table)
+	{
+		if (mPosition == mEnd) return false;
+
+		*status = RecordStatus::given;
+		if (!parse_sudoku_text(mPosition, mEnd, cells, size))
+		{
+			*size = 0;
+			*status = RecordStatus::invalid;
+		}
+		mPosition = mEnd;
+		return true;
+	}
+
+	while (mPosition < mEnd)
+	{
+		const auto line = mPosition;
+		auto line_end = find_line_end(mPosition, mEnd);
+		mPosition = line_end == mEnd ? mEnd : line_end + 1;
+
+		if (line_end > line && line_end[-1] == '\r') --line_end;
+		if (line_end == line || *line == '#') continue;
+
+		*status = RecordStatus::given;
+		if (!parse_sudoku_line(line, line_end, cells, size))
+		{
+			*size = 0;
+			*status = RecordStatus::invalid;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+bool CorpusReader::next_binary(std::vector<int>* cells, int* size, RecordStatus* status)
+{
+	if (mNext == mCount) return false;
+
+	const auto offset = read_u64(mIndex + mNext++ * sizeof(std::uint64_t));
+	const auto file_size = mFile.size();
+
+	*size = 0;
+	*status = RecordStatus::invalid;
+	cells->clear();
+
+	if (offset > file_size || file_size - offset < RECORD_HEADER_BYTES) return true;
+
+	const auto record = mFile.data() + offset;
+	const auto record_size = read_u32(record);
+	const auto record_status = read_u32(record + 4);
+
+	const auto n = std::uint32_t(std::lround(std::sqrt(double(record_size))));
+	if (record_size == 0 || n * n != record_size || record_size > 1 << 16 || record_status > std::uint32_t(RecordStatus::invalid) ||
+		file_size - offset < get_record_bytes(int(record_size)))
+		return true;
+
+	const auto count = std::size_t(record_size) * record_size;
+	cells->resize(count);
+
+	const auto packed = reinterpret_cast<const unsigned char*>(record + RECORD_HEADER_BYTES);
+	const auto bits = get_cell_bits(int(record_size));
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		int number;
+		if (bits == 4) number = (packed[i / 2] >> (i % 2 * 4)) & 0xf;
+		else if (bits == 8) number = packed[i];
+		else number = packed[2 * i] | packed[2 * i + 1] << 8;
+
+		if (std::uint32_t(number) > record_size) return true;
+		(*cells)[i] = number;
+	}
+
+	*size = int(record_size);
+	*status = RecordStatus(record_status);
+	return true;
+}
+
+CorpusWriter::CorpusWriter(const std::string& path, const CorpusFormat format) :
+	mFile(path, std::ios::binary | std::ios::trunc), mFormat(format)
+{
+	mBuffer.reserve(WRITE_BLOCK_BYTES + (1 << 16));
+
+	//the header is completed by finish()
+	if (mFormat == CorpusFormat::binary)
+	{
+		mBuffer.append(CORPUS_MAGIC, sizeof(CORPUS_MAGIC));
+		mBuffer.append(CORPUS_HEADER_BYTES - sizeof(CORPUS_MAGIC), '\0');
+		mOffset = CORPUS_HEADER_BYTES;
+	}
+}
+
+CorpusFormat CorpusWriter::get_format(const std::string& path)
+{
+	static const std::string extension = ".corpus";
+	if (path.size() > extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0)
+		return CorpusFormat::binary;
+	return CorpusFormat::text;
+}
+
+void CorpusWriter::write(const int* cells, const int size, const RecordStatus status)
+{
+	if (mFormat != CorpusFormat::binary)
+	{
+		switch (status)
+		{
+		case RecordStatus::given:
+		case RecordStatus::solved: append_sudoku_line(cells, size, &mBuffer); break;
+		case RecordStatus::unsolvable: mBuffer += "unsolvable"; break;
+		case RecordStatus::unknown: mBuffer += "unknown"; break;
+		case RecordStatus::invalid: mBuffer += "error"; break;
+		}
+		mBuffer += '\n';
+	}
+	else
+	{
+		mIndex.push_back(mOffset);
+
+		const auto record_size = std::uint32_t(size);
+		const auto record_status = std::uint32_t(status);
+		append_bytes(&mBuffer, &record_size, sizeof(record_size));
+		append_bytes(&mBuffer, &record_status, sizeof(record_status));
+
+		const auto count = std::size_t(size) * size;
+		const auto bits = get_cell_bits(size);
+		if (bits == 4)
+		{
+			for (std::size_t i = 0; i < count; i += 2)
+				mBuffer += char(cells[i] | (i + 1 < count ? cells[i + 1] << 4 : 0));
+		}
+		else if (bits == 8)
+		{
+			for (std::size_t i = 0; i < count; ++i) mBuffer += char(cells[i]);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				mBuffer += char(cells[i] & 0xff);
+				mBuffer += char(cells[i] >> 8);
+			}
+		}
+
+		mOffset += get_record_bytes(size);
+	}
+
+	if (mBuffer.size() >= WRITE_BLOCK_BYTES) flush();
+}
+
+void CorpusWriter::flush()
+{
+	mFile.write(mBuffer.data(), std::streamsize(mBuffer.size()));
+	mBuffer.clear();
+}
+
+bool CorpusWriter::finish()
+{
+	if (mFormat == CorpusFormat::binary)
+	{
+		append_bytes(&mBuffer, mIndex.data(), mIndex.size() * sizeof(std::uint64_t));
+		flush();
+
+		const std::uint64_t header[] = {mIndex.size(), mOffset};
+		mFile.seekp(sizeof(CORPUS_MAGIC));
+		mFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+	}
+	else flush();
+
+	mFile.close();
+	return !mFile.fail();
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+//many sudokus in one file, so millions of small ones don't need a file each
+//	text: one sudoku per line in the format of parse_sudoku_line(), empty lines and lines starting with # are skipped
+//	binary: an index header followed by packed records, see CorpusWriter
+//	table: a single sudoku file as read by parse_sudoku_text(), a corpus of one
+enum class CorpusFormat
+{
+	text,
+	binary,
+	table
+};
+
+//what a record holds, the sudokus to solve are given ones, the output of solve_corpus() tells what became of each of them
+enum class RecordStatus : std::uint32_t
+{
+	given,
+	solved,
+	unsolvable,
+	unknown,		//the solver hit a limit
+	invalid			//the record is no sudoku
+};
+
+//reads a corpus through a mapping, record by record, the format is recognized by the content
+class CorpusReader
+{
+public:
+	explicit CorpusReader(const std::string& path);
+
+	bool is_open() const;
+	CorpusFormat get_format() const;
+	std::size_t get_bytes() const;
+
+	//the next record, cells row by row with 0 for an empty cell, returns false at the end
+	//an invalid record has size 0, so the records stay in step with the input
+	bool next(std::vector<int>* cells, int* size, RecordStatus* status);
+
+private:
+	bool next_binary(std::vector<int>* cells, int* size, RecordStatus* status);
+
+	MappedFile mFile;
+	CorpusFormat mFormat = CorpusFormat::text;
+	bool mOpen = false;
+
+	const char* mPosition = nullptr;		//text and table: the rest of the file
+	const char* mEnd = nullptr;
+
+	std::uint64_t mCount = 0;				//binary: records and where their offsets are
+	std::uint64_t mNext = 0;
+	const char* mIndex = nullptr;
+};
+
+//writes a corpus, the binary format is little endian:
+//	"SUDOCOR1", u64 record count, u64 offset of the index
+//	the records: u32 size, u32 status, the cells with 4 bits each below 16x16, 8 bits below 256x256 and 16 bits above
+//	the index: u64 offset of every record
+//the text format gets a line per record, solved and given sudokus as their cells, the others as their status
+class CorpusWriter
+{
+public:
+	CorpusWriter(const std::string& path, CorpusFormat format);
+
+	//binary for paths ending in .corpus, text otherwise
+	static CorpusFormat get_format(const std::string& path);
+
+	void write(const int* cells, int size, RecordStatus status);
+
+	//writes the index of a binary corpus, returns false if anything couldn't be written
+	bool finish();
+
+private:
+	void flush();
+
+	std::ofstream mFile;
+	CorpusFormat mFormat;
+	std::string mBuffer;					//records are collected and written in large blocks
+	std::uint64_t mOffset = 0;				//of the next record in the file
+	std::vector<std::uint64_t> mIndex;
+};
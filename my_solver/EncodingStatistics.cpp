@@ -0,0 +1,83 @@
+#include "pch.h"
+#include "EncodingStatistics.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static const char* CLAUSE_FAMILY_NAMES[CLAUSE_FAMILY_COUNT] = {"cell_definedness", "cell_uniqueness", "row_definedness", "row_uniqueness",
+															   "column_definedness", "column_uniqueness", "section_definedness",
+															   "section_uniqueness"};
+
+//quotes a string for json, the paths are the only strings that aren't known in advance
+static std::string quote_json(const std::string& text)
+{
+	std::string quoted = "\"";
+	for (auto character : text)
+	{
+		if (character == '"' || character == '\\') quoted += '\\';
+		if (static_cast<unsigned char>(character) < 0x20) quoted += ' ';
+		else quoted += character;
+	}
+	return quoted + "\"";
+}
+
+const char* get_clause_family_name(const ClauseFamily family)
+{
+	return CLAUSE_FAMILY_NAMES[int(family)];
+}
+
+void EncodingStatistics::reset()
+{
+	std::fill(clauses, clauses + CLAUSE_FAMILY_COUNT, 0);
+	std::fill(literals, literals + CLAUSE_FAMILY_COUNT, 0);
+	std::fill(clause_lengths.begin(), clause_lengths.end(), 0);
+	atoms = 0;
+	commander_atoms = 0;
+	pruned_atoms = 0;
+	dimacs_bytes = 0;
+}
+
+std::string get_encoding_report_path(const std::string& benchmark_path)
+{
+	const std::string extension = ".csv";
+	const auto has_extension = benchmark_path.size() >= extension.size()
+							&& benchmark_path.compare(benchmark_path.size() - extension.size(), extension.size(), extension) == 0;
+	return (has_extension ? benchmark_path.substr(0, benchmark_path.size() - extension.size()) : benchmark_path) + ".encoding.jsonl";
+}
+
+void append_encoding_report(const std::string& path, const std::string& sudoku, const int size, const std::string& solver,
+							const EncodingStatistics& statistics)
+{
+	std::int64_t clauses = 0, literals = 0;
+	for (auto family = 0; family < CLAUSE_FAMILY_COUNT; ++family)
+	{
+		clauses += statistics.clauses[family];
+		literals += statistics.literals[family];
+	}
+
+	//the line is built first, so it's appended in one piece
+	std::stringstream line;
+	line << "{\"sudoku\":" << quote_json(sudoku) << ",\"size\":" << size << ",\"solver\":" << quote_json(solver)
+		 << ",\"atoms\":" << statistics.atoms << ",\"commander_atoms\":" << statistics.commander_atoms
+		 << ",\"pruned_atoms\":" << statistics.pruned_atoms << ",\"clauses\":" << clauses << ",\"literals\":" << literals
+		 << ",\"dimacs_bytes\":" << statistics.dimacs_bytes << ",\"families\":{";
+
+	for (auto family = 0; family < CLAUSE_FAMILY_COUNT; ++family)
+	{
+		line << (family ? "," : "") << "\"" << CLAUSE_FAMILY_NAMES[family] << "\":{\"clauses\":" << statistics.clauses[family]
+			 << ",\"literals\":" << statistics.literals[family] << "}";
+	}
+
+	line << "},\"clause_lengths\":{";
+	auto first = true;
+	for (std::size_t length = 0; length < statistics.clause_lengths.size(); ++length)
+	{
+		if (!statistics.clause_lengths[length]) continue;
+		line << (first ? "" : ",") << "\"" << length << "\":" << statistics.clause_lengths[length];
+		first = false;
+	}
+	line << "}}\n";
+
+	std::ofstream report(path, std::ofstream::out | std::ofstream::app);
+	report << line.str();
+}
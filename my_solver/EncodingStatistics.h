@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//the families of clauses the encoder writes, the clauses of the at most one encodings count for the family that asked for them
+enum class ClauseFamily
+{
+	cell_definedness,
+	cell_uniqueness,
+	row_definedness,
+	row_uniqueness,
+	column_definedness,
+	column_uniqueness,
+	section_definedness,
+	section_uniqueness
+};
+
+const int CLAUSE_FAMILY_COUNT = 8;
+
+const char* get_clause_family_name(ClauseFamily family);
+
+//what the encoding of a sudoku consists of, collected while the clauses are written
+struct EncodingStatistics
+{
+	std::int64_t clauses[CLAUSE_FAMILY_COUNT] = {};
+	std::int64_t literals[CLAUSE_FAMILY_COUNT] = {};
+	std::vector<std::int64_t> clause_lengths;		//amount of clauses of every length
+
+	int atoms = 0;					//one per candidate that survived the preprocessing
+	int commander_atoms = 0;		//added by the commander encoding
+	int pruned_atoms = 0;			//candidates the preprocessing ruled out, size^3 - atoms
+	std::int64_t dimacs_bytes = 0;	//size of the cnf written by write_clauses()
+
+	void add_clause(const ClauseFamily family, const std::size_t length)
+	{
+		++clauses[int(family)];
+		literals[int(family)] += length;
+		if (clause_lengths.size() <= length) clause_lengths.resize(length + 1);
+		++clause_lengths[length];
+	}
+
+	//forgets the clauses, the buffer of the histogram is kept
+	void reset();
+};
+
+//the encoding report lives next to the benchmark csv, results.csv gets results.encoding.jsonl
+std::string get_encoding_report_path(const std::string& benchmark_path);
+
+//appends the statistics of a sudoku as a line of json:
+//{"sudoku":..., "size":..., "solver":..., "atoms":..., "commander_atoms":..., "pruned_atoms":..., "clauses":..., "literals":...,
+// "dimacs_bytes":..., "families":{"row_uniqueness":{"clauses":..., "literals":...}, ...}, "clause_lengths":{"2":..., ...}}
+void append_encoding_report(const std::string& path, const std::string& sudoku, int size, const std::string& solver,
+							const EncodingStatistics& statistics);
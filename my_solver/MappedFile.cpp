@@ -0,0 +1,54 @@
+#include "pch.h"
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path)
+{
+	const auto file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file == -1) return;
+
+	struct stat status;
+	if (fstat(file, &status) == 0 && S_ISREG(status.st_mode))
+	{
+		if (status.st_size == 0) mOpen = true;
+		else
+		{
+			const auto mapping = mmap(nullptr, std::size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapping != MAP_FAILED)
+			{
+				//the parsers and the checkpoints read front to back exactly once
+				madvise(mapping, std::size_t(status.st_size), MADV_SEQUENTIAL);
+
+				mData = static_cast<const char*>(mapping);
+				mSize = std::size_t(status.st_size);
+				mOpen = true;
+			}
+		}
+	}
+
+	//the mapping stays valid without the descriptor
+	close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData) munmap(const_cast<char*>(mData), mSize);
+}
+
+bool MappedFile::is_open() const
+{
+	return mOpen;
+}
+
+const char* MappedFile::data() const
+{
+	return mData;
+}
+
+std::size_t MappedFile::size() const
+{
+	return mSize;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+//a file mapped read only into memory, the parsers and the checkpoints work on its bytes directly instead of copying them
+//into lines and streams
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//an empty file is open but has no data
+	bool is_open() const;
+
+	const char* data() const;
+	std::size_t size() const;
+
+private:
+	const char* mData = nullptr;
+	std::size_t mSize = 0;
+	bool mOpen = false;
+};
@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "PerfCounters.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::atomic<bool> counters_enabled(false);
+
+static const char* COUNTER_NAMES[HARDWARE_COUNTER_COUNT] = {"cycles", "instructions", "llc-misses", "branch-misses"};
+static const std::uint64_t COUNTER_CONFIGS[HARDWARE_COUNTER_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+																	 PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+//the counters of one thread, every counter is opened on its own so the ones that exist are used even if others don't
+struct ThreadCounters
+{
+	int files[HARDWARE_COUNTER_COUNT] = {-1, -1, -1, -1};
+	bool opened = false;
+	int error = 0;			//errno of the last counter that couldn't be opened
+
+	~ThreadCounters()
+	{
+		for (auto file : files)
+			if (file != -1) close(file);
+	}
+
+	void open()
+	{
+		opened = true;
+		for (auto i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+		{
+			struct perf_event_attr attributes;
+			std::memset(&attributes, 0, sizeof(attributes));
+			attributes.size = sizeof(attributes);
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.config = COUNTER_CONFIGS[i];
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			files[i] = int(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+			if (files[i] == -1) error = errno;
+		}
+	}
+
+	bool has_counters() const
+	{
+		for (auto file : files)
+			if (file != -1) return true;
+		return false;
+	}
+};
+
+static thread_local ThreadCounters thread_counters;
+
+std::string get_hardware_counter_name(const HardwareCounter counter)
+{
+	return COUNTER_NAMES[int(counter)];
+}
+
+bool enable_counters()
+{
+	thread_counters.open();
+	if (!thread_counters.has_counters())
+	{
+		std::cerr << "Hardware counters are unavailable: " << std::strerror(thread_counters.error)
+				  << ", check /proc/sys/kernel/perf_event_paranoid. Continuing without them." << std::endl;
+		return false;
+	}
+
+	for (auto i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+		if (thread_counters.files[i] == -1) std::cerr << "The hardware counter " << COUNTER_NAMES[i] << " is unavailable." << std::endl;
+
+	counters_enabled = true;
+	return true;
+}
+
+bool read_counters(CounterValues* values)
+{
+	if (!counters_enabled.load(std::memory_order_relaxed)) return false;
+	if (!thread_counters.opened) thread_counters.open();
+
+	auto any = false;
+	for (auto i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+	{
+		values->values[i] = -1;
+
+		//the count, the time the counter was enabled and the time it actually ran on the cpu
+		std::uint64_t data[3];
+		if (thread_counters.files[i] == -1 || read(thread_counters.files[i], data, sizeof(data)) != sizeof(data)) continue;
+
+		if (data[2] == 0) values->values[i] = 0;
+		else if (data[2] < data[1]) values->values[i] = std::int64_t(double(data[0]) * data[1] / data[2]);
+		else values->values[i] = std::int64_t(data[0]);
+		any = true;
+	}
+	return any;
+}
+
+CounterValues get_counter_difference(const CounterValues& start, const CounterValues& end)
+{
+	CounterValues difference;
+	for (auto i = 0; i < HARDWARE_COUNTER_COUNT; ++i)
+		if (start.values[i] != -1 && end.values[i] != -1) difference.values[i] = end.values[i] - start.values[i];
+	return difference;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//hardware counters of the cpu read with perf_event_open, counted for the calling thread in user space only
+enum class HardwareCounter
+{
+	cycles,
+	instructions,
+	llc_misses,			//last level cache misses
+	branch_misses
+};
+
+const int HARDWARE_COUNTER_COUNT = 4;
+
+std::string get_hardware_counter_name(HardwareCounter counter);
+
+//the counts of a thread, a counter the cpu or the kernel doesn't offer stays -1
+//if the kernel multiplexes the counters the counts are scaled up to the whole time
+struct CounterValues
+{
+	std::int64_t values[HARDWARE_COUNTER_COUNT] = {-1, -1, -1, -1};
+
+	std::int64_t get(const HardwareCounter counter) const { return values[int(counter)]; }
+};
+
+extern std::atomic<bool> counters_enabled;
+
+//turns the counters on for every thread, they are opened on the first read of a thread
+//returns false and says why if not a single counter can be opened, e.g. in a container or with perf_event_paranoid set too high
+bool enable_counters();
+
+//the counts of the calling thread since its counters were opened, returns false if counters are off or unavailable
+bool read_counters(CounterValues* values);
+
+//what was counted between two reads, -1 where either read has no count
+CounterValues get_counter_difference(const CounterValues& start, const CounterValues& end);
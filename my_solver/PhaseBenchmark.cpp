@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "PhaseBenchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+static const char* PHASE_NAMES[PHASE_COUNT] = {"parse", "preprocess", "lut", "encode", "write", "solver", "decode", "render"};
+
+//two sided 95% quantiles of the t distribution for 1 to 30 degrees of freedom, the normal one above
+static const double T_QUANTILES[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+									 2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+const int T_QUANTILE_COUNT = sizeof(T_QUANTILES) / sizeof(T_QUANTILES[0]);
+
+std::string get_phase_name(const Phase phase)
+{
+	return PHASE_NAMES[int(phase)];
+}
+
+bool parse_phase_name(const std::string& name, Phase* phase)
+{
+	for (auto i = 0; i < PHASE_COUNT; ++i)
+	{
+		if (name == PHASE_NAMES[i])
+		{
+			*phase = Phase(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+PhaseStatistics summarize_samples(std::vector<double> samples)
+{
+	PhaseStatistics statistics;
+	if (samples.empty()) return statistics;
+
+	std::sort(samples.begin(), samples.end());
+	const auto count = samples.size();
+
+	statistics.min = samples.front();
+	statistics.median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+	statistics.p95 = samples[std::size_t(std::ceil(0.95 * count)) - 1];
+	return statistics;
+}
+
+std::vector<std::string> split_csv_line(const std::string& line)
+{
+	std::vector<std::string> columns;
+	std::stringstream row(line);
+	std::string column;
+	while (std::getline(row, column, ',')) columns.push_back(column);
+	return columns;
+}
+
+//the instances are compared by file name, extable9-1.txt of the benchmark folders is table9-1.txt of instances/
+static std::string get_instance_name(const std::string& path)
+{
+	const auto slash = path.rfind('/');
+	auto name = slash == std::string::npos ? path : path.substr(slash + 1);
+	if (name.compare(0, 7, "extable") == 0) name.erase(0, 2);
+	return name;
+}
+
+static std::vector<std::string> read_csv_header(const std::string& path)
+{
+	std::ifstream csv(path);
+	std::string line;
+	if (!std::getline(csv, line)) return {};
+	return split_csv_line(line);
+}
+
+bool is_totals_only(const std::string& path)
+{
+	const auto header = read_csv_header(path);
+	return std::find(header.begin(), header.end(), "Phase") == header.end() && std::find(header.begin(), header.end(), "Seconds") != header.end();
+}
+
+bool read_phase_medians(const std::string& path, std::vector<std::pair<std::string, std::string>>* keys, std::vector<double>* medians)
+{
+	std::ifstream csv(path);
+	std::string line;
+	if (!std::getline(csv, line)) return false;
+
+	const auto header = split_csv_line(line);
+	const auto find_column = [&header](const std::string& name) {
+		return int(std::find(header.begin(), header.end(), name) - header.begin());
+	};
+
+	const auto sudoku_column = find_column("Sudoku");
+	const auto phase_column = find_column("Phase");
+	auto seconds_column = find_column("Median Seconds");
+
+	//a csv of the benchmark command has the total seconds of one run
+	const auto totals_only = phase_column == int(header.size());
+	if (totals_only) seconds_column = find_column("Seconds");
+
+	if (sudoku_column == int(header.size()) || seconds_column == int(header.size())) return false;
+
+	while (std::getline(csv, line))
+	{
+		const auto columns = split_csv_line(line);
+		if (int(columns.size()) <= std::max(std::max(sudoku_column, seconds_column), totals_only ? 0 : phase_column)) continue;
+
+		keys->push_back({get_instance_name(columns[sudoku_column]), totals_only ? "total" : columns[phase_column]});
+		medians->push_back(std::atof(columns[seconds_column].c_str()));
+	}
+	return true;
+}
+
+bool compare_to_baseline(const std::string& baseline_path, const std::string& current_path, const double threshold, const double min_seconds)
+{
+	std::vector<std::pair<std::string, std::string>> baseline_keys, current_keys;
+	std::vector<double> baseline_medians, current_medians;
+	if (!read_phase_medians(baseline_path, &baseline_keys, &baseline_medians))
+	{
+		std::cerr << "Couldn't read the baseline \"" << baseline_path << "\"." << std::endl;
+		return false;
+	}
+	if (!read_phase_medians(current_path, &current_keys, &current_medians))
+	{
+		std::cerr << "Couldn't read the benchmark \"" << current_path << "\"." << std::endl;
+		return false;
+	}
+
+	std::map<std::pair<std::string, std::string>, double> baseline;
+	for (std::size_t i = 0; i < baseline_keys.size(); ++i) baseline[baseline_keys[i]] = baseline_medians[i];
+
+	//phase -> log of the speedup of every sudoku, in the order the phases first appear
+	std::vector<std::string> phases;
+	std::map<std::string, std::vector<double>> log_speedups;
+
+	std::cout << "Speedup over the baseline (baseline / current median seconds):" << std::endl;
+	std::string printed_instance;
+	for (std::size_t i = 0; i < current_keys.size(); ++i)
+	{
+		const auto match = baseline.find(current_keys[i]);
+		if (match == baseline.end()) continue;
+
+		const auto& instance = current_keys[i].first;
+		const auto& phase = current_keys[i].second;
+		if (std::find(phases.begin(), phases.end(), phase) == phases.end()) phases.push_back(phase);
+
+		if (instance != printed_instance)
+		{
+			if (!printed_instance.empty()) std::cout << std::endl;
+			std::cout << "  " << instance << ":";
+			printed_instance = instance;
+		}
+
+		if (match->second < min_seconds || current_medians[i] <= 0)
+		{
+			std::cout << " " << phase << " -";
+			continue;
+		}
+
+		const auto speedup = match->second / current_medians[i];
+		std::cout << " " << phase << " " << std::setprecision(3) << speedup;
+		log_speedups[phase].push_back(std::log(speedup));
+	}
+	if (!printed_instance.empty()) std::cout << std::endl;
+
+	if (phases.empty())
+	{
+		std::cerr << "No Sudoku of the benchmark is in the baseline." << std::endl;
+		return false;
+	}
+
+	auto regressed = false;
+	std::cout << "Geometric mean speedup per phase, 95% confidence interval, regression threshold " << threshold * 100 << "%:" << std::endl;
+	for (const auto& phase : phases)
+	{
+		const auto& logs = log_speedups[phase];
+		std::cout << "  " << std::left << std::setw(12) << phase << std::right;
+		if (logs.empty())
+		{
+			std::cout << "too fast to compare" << std::endl;
+			continue;
+		}
+
+		const auto count = logs.size();
+		auto mean = 0.;
+		for (auto value : logs) mean += value;
+		mean /= count;
+
+		auto variance = 0.;
+		for (auto value : logs) variance += (value - mean) * (value - mean);
+		variance = count > 1 ? variance / (count - 1) : 0;
+
+		const auto t = count > 1 ? (count - 1 <= std::size_t(T_QUANTILE_COUNT) ? T_QUANTILES[count - 2] : 1.96) : 0;
+		const auto margin = t * std::sqrt(variance / count);
+
+		const auto speedup = std::exp(mean);
+		//noise alone mustn't fail the comparison, the whole interval has to be slower as well
+		const auto regression = speedup < 1 / (1 + threshold) && mean + margin < 0;
+		regressed = regressed || regression;
+
+		std::cout << std::setprecision(3) << speedup << " [" << std::exp(mean - margin) << ", " << std::exp(mean + margin) << "] over "
+				  << count << " Sudokus" << (regression ? "  REGRESSION" : "") << std::endl;
+	}
+
+	std::cout << std::setprecision(6);
+	return !regressed;
+}
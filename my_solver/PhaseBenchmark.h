@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//the steps from the sudoku file to the printed solution, timed one by one by the bench command
+enum class Phase
+{
+	parse,			//reading the file into a new sudoku
+	preprocess,		//simple_solve()
+	lut,			//create_lut()
+	encode,			//generate_all_clauses()
+	write,			//write_clauses()
+	solver,			//the solver run, only with a solver
+	decode,			//read_solution()
+	render			//formatting the solved grid
+};
+
+const int PHASE_COUNT = 8;
+
+std::string get_phase_name(Phase phase);
+bool parse_phase_name(const std::string& name, Phase* phase);
+
+//summary of the repeated timings of a phase, the p95 is the nearest rank
+struct PhaseStatistics
+{
+	double median = 0;
+	double min = 0;
+	double p95 = 0;
+};
+
+PhaseStatistics summarize_samples(std::vector<double> samples);
+
+//splits a line of a csv at the commas, the csvs written here never quote a column
+std::vector<std::string> split_csv_line(const std::string& line);
+
+//the median seconds of every sudoku and phase in a csv of the bench command, keyed by the file name of the sudoku
+//a csv of the benchmark command only has the total seconds, those become the phase "total"
+//returns false if the file can't be read or has neither format
+bool read_phase_medians(const std::string& path, std::vector<std::pair<std::string, std::string>>* keys, std::vector<double>* medians);
+
+//true for a csv of the benchmark command, its seconds include the solver, so only a total with the solver can be compared to them
+bool is_totals_only(const std::string& path);
+
+//matches the sudokus of the current csv with the baseline and prints the speedup of every sudoku and phase and the
+//geometric mean of every phase with its 95% confidence interval, phases faster than min_seconds in the baseline are too noisy
+//to count, returns false if the geometric mean of any phase is slower than the baseline by more than the threshold (0.1 = 10%)
+//and its whole confidence interval is below a speedup of 1
+bool compare_to_baseline(const std::string& baseline_path, const std::string& current_path, double threshold, double min_seconds);
@@ -0,0 +1,79 @@
+#include "pch.h"
+#include "ScratchFile.h"
+#include <atomic>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//numbers the fallback files, so concurrent jobs never pick the same name
+static std::atomic<unsigned> scratch_counter(0);
+
+ScratchFile::ScratchFile(const std::string& name)
+{
+	//the descriptors are close on exec, the solver opens the file through /proc/<pid>/fd of this process,
+	//so concurrently started solvers don't inherit each other's files
+#ifdef SYS_memfd_create
+	mFd = int(syscall(SYS_memfd_create, name.c_str(), MFD_CLOEXEC));
+	mIn_memory = mFd != -1;
+#endif
+
+#ifdef O_TMPFILE
+	if (mFd == -1)
+		mFd = open(".", O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+
+	if (mFd == -1)
+	{
+		mFallback_name = name + "." + std::to_string(getpid()) + "." + std::to_string(scratch_counter++);
+		mFd = open(mFallback_name.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0600);
+		mPath = mFallback_name;
+		return;
+	}
+
+	mPath = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(mFd);
+}
+
+ScratchFile::~ScratchFile()
+{
+	release();
+}
+
+ScratchFile::ScratchFile(ScratchFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+ScratchFile& ScratchFile::operator=(ScratchFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		mFd = other.mFd;
+		mIn_memory = other.mIn_memory;
+		mPath = std::move(other.mPath);
+		mFallback_name = std::move(other.mFallback_name);
+		other.mFd = -1;
+		other.mFallback_name.clear();
+	}
+	return *this;
+}
+
+const std::string& ScratchFile::get_path() const
+{
+	return mPath;
+}
+
+bool ScratchFile::is_in_memory() const
+{
+	return mIn_memory;
+}
+
+void ScratchFile::release()
+{
+	if (mFd != -1) close(mFd);
+	if (!mFallback_name.empty()) std::remove(mFallback_name.c_str());
+	mFd = -1;
+	mFallback_name.clear();
+}
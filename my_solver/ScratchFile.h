@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+//a temporary file that only lives as long as this object, used for the cnf and the model
+//it is created with memfd_create, so it never touches the disk, or with O_TMPFILE in the working directory if memfd is missing
+//either way it has no name, get_path() returns /proc/<pid>/fd/<fd> which the encoder and the solver can open like a file
+//if neither works it falls back to a normal file with a name unique to this process, which is deleted again
+class ScratchFile
+{
+public:
+	ScratchFile() = default;
+	explicit ScratchFile(const std::string& name);
+	~ScratchFile();
+
+	ScratchFile(ScratchFile&& other) noexcept;
+	ScratchFile& operator=(ScratchFile&& other) noexcept;
+	ScratchFile(const ScratchFile&) = delete;
+	ScratchFile& operator=(const ScratchFile&) = delete;
+
+	const std::string& get_path() const;
+
+	bool is_in_memory() const;
+
+private:
+	void release();
+
+	int mFd = -1;
+	bool mIn_memory = false;
+	std::string mPath;
+	std::string mFallback_name;		//only set if a named file had to be used
+};
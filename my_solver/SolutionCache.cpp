@@ -0,0 +1,422 @@
+#include "pch.h"
+#include "SolutionCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//the row and column orders tried for one orientation are limited to about this many cells in total
+const std::uint64_t CANONICAL_WORK_LIMIT = 1 << 20;
+
+//first bytes of a cache file, followed by the entries: key length, solution length (both 32 bit), key, solution
+const char CACHE_FILE_MAGIC[8] = {'S', 'U', 'D', 'O', 'C', 'A', 'C', '1'};
+
+namespace
+{
+	//the orders of the rows (or columns) the invariants allow: bands by the ranks of their lines, the lines inside by their rank
+	//lines or bands with equal keys can't be told apart and are tied, every permutation of a tie has to be tried
+	struct LineOrder
+	{
+		struct Tie
+		{
+			int band;		//-1 for a tie of bands, otherwise the band whose lines are tied
+			int begin;
+			int end;
+		};
+
+		std::vector<int> bands;
+		std::vector<std::vector<int>> lines;		//the lines of every band as indices into the sudoku
+		std::vector<Tie> ties;
+		std::uint64_t arrangements = 1;				//all permutations of the ties, saturates above CANONICAL_WORK_LIMIT
+
+		void get_lines(std::vector<int>* order) const
+		{
+			order->clear();
+			for (auto band : bands)
+				for (auto line : lines[band])
+					order->push_back(line);
+		}
+
+		//goes to the next arrangement of the ties like an odometer, returns false after the last one, which is the first one again
+		bool next()
+		{
+			for (const auto& tie : ties)
+			{
+				auto& values = tie.band == -1 ? bands : lines[tie.band];
+				if (std::next_permutation(values.begin() + tie.begin, values.begin() + tie.end)) return true;
+			}
+			return false;
+		}
+
+		void add_tie(const int band, const int begin, const int end)
+		{
+			if (end - begin < 2) return;
+			ties.push_back({band, begin, end});
+			for (auto i = 2; i <= end - begin && arrangements <= CANONICAL_WORK_LIMIT; ++i) arrangements *= i;
+		}
+	};
+}
+
+//ranks the rows by what every symmetry keeps: their amount of givens, the amount of givens in the columns they meet
+//and how often their numbers are given, rows with the same rank can't be told apart this way
+static std::vector<int> rank_lines(const std::vector<int>& cells, const int size, const std::vector<int>& frequency)
+{
+	std::vector<int> column_count(size, 0);
+	for (auto y = 0; y < size; ++y)
+		for (auto x = 0; x < size; ++x)
+			if (cells[std::size_t(y) * size + x]) ++column_count[x];
+
+	std::vector<std::vector<int>> signatures(size);
+	std::vector<int> columns, numbers;
+	for (auto y = 0; y < size; ++y)
+	{
+		columns.clear();
+		numbers.clear();
+		for (auto x = 0; x < size; ++x)
+		{
+			const auto number = cells[std::size_t(y) * size + x];
+			if (!number) continue;
+			columns.push_back(column_count[x]);
+			numbers.push_back(frequency[number]);
+		}
+		std::sort(columns.begin(), columns.end());
+		std::sort(numbers.begin(), numbers.end());
+
+		auto& signature = signatures[y];
+		signature.push_back(int(columns.size()));
+		signature.insert(signature.end(), columns.begin(), columns.end());
+		signature.insert(signature.end(), numbers.begin(), numbers.end());
+	}
+
+	auto distinct = signatures;
+	std::sort(distinct.begin(), distinct.end());
+	distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+	std::vector<int> ranks(size);
+	for (auto y = 0; y < size; ++y)
+		ranks[y] = int(std::lower_bound(distinct.begin(), distinct.end(), signatures[y]) - distinct.begin());
+	return ranks;
+}
+
+static void order_lines(const std::vector<int>& ranks, const int n, LineOrder* order)
+{
+	std::vector<std::vector<int>> band_keys(n);
+	order->lines.assign(n, std::vector<int>());
+	order->bands.clear();
+
+	const auto by_rank = [&](const int a, const int b) { return ranks[a] < ranks[b]; };
+
+	for (auto band = 0; band < n; ++band)
+	{
+		auto& lines = order->lines[band];
+		for (auto line = band * n; line < (band + 1) * n; ++line) lines.push_back(line);
+		std::stable_sort(lines.begin(), lines.end(), by_rank);
+
+		for (auto line : lines) band_keys[band].push_back(ranks[line]);
+		order->bands.push_back(band);
+	}
+
+	std::stable_sort(order->bands.begin(), order->bands.end(), [&](const int a, const int b) { return band_keys[a] < band_keys[b]; });
+
+	for (auto begin = 0; begin < n;)
+	{
+		auto end = begin + 1;
+		while (end < n && band_keys[order->bands[end]] == band_keys[order->bands[begin]]) ++end;
+		order->add_tie(-1, begin, end);
+		begin = end;
+	}
+
+	for (auto band = 0; band < n; ++band)
+	{
+		const auto& lines = order->lines[band];
+		for (auto begin = 0; begin < n;)
+		{
+			auto end = begin + 1;
+			while (end < n && ranks[lines[end]] == ranks[lines[begin]]) ++end;
+			order->add_tie(band, begin, end);
+			begin = end;
+		}
+	}
+}
+
+//writes the sudoku in the given row and column order, relabelled by first appearance, into candidate
+//and returns true if it is smaller than best, stops as soon as it is larger
+static bool relabel_if_smaller(const std::vector<int>& cells, const int size, const std::vector<int>& rows, const std::vector<int>& columns,
+							   std::vector<int>* candidate, std::vector<int>* numbers, const std::vector<int>& best)
+{
+	std::fill(numbers->begin(), numbers->end(), 0);
+	auto next_number = 0;
+	auto smaller = best.empty();
+
+	std::size_t cell = 0;
+	for (auto i = 0; i < size; ++i)
+	{
+		const auto row = &cells[std::size_t(rows[i]) * size];
+		for (auto j = 0; j < size; ++j, ++cell)
+		{
+			auto number = row[columns[j]];
+			if (number)
+			{
+				if (!(*numbers)[number]) (*numbers)[number] = ++next_number;
+				number = (*numbers)[number];
+			}
+
+			if (!smaller)
+			{
+				if (number > best[cell]) return false;
+				if (number < best[cell]) smaller = true;
+			}
+			(*candidate)[cell] = number;
+		}
+	}
+
+	return smaller;
+}
+
+void canonicalize(const std::vector<int>& cells, const int size, CanonicalSudoku* canonical)
+{
+	const auto n = int(std::lround(std::sqrt(size)));
+	const auto area = std::size_t(size) * size;
+
+	std::vector<int> frequency(size + 1, 0);
+	for (auto number : cells) ++frequency[number];
+
+	std::vector<int> transposed_cells(area);
+	for (auto y = 0; y < size; ++y)
+		for (auto x = 0; x < size; ++x)
+			transposed_cells[std::size_t(x) * size + y] = cells[std::size_t(y) * size + x];
+
+	canonical->size = size;
+	canonical->cells.clear();
+
+	std::vector<int> candidate(area), numbers(size + 1), rows, columns;
+	const auto max_arrangements = std::max<std::uint64_t>(1, CANONICAL_WORK_LIMIT / area);
+
+	for (auto transposed = 0; transposed < 2; ++transposed)
+	{
+		const auto& grid = transposed ? transposed_cells : cells;
+
+		LineOrder row_order, column_order;
+		order_lines(rank_lines(grid, size, frequency), n, &row_order);
+		order_lines(rank_lines(transposed ? cells : transposed_cells, size, frequency), n, &column_order);
+
+		//with too many ties only the order of the invariants is tried
+		const auto enumerate = row_order.arrangements * column_order.arrangements <= max_arrangements;
+
+		do
+		{
+			row_order.get_lines(&rows);
+			do
+			{
+				column_order.get_lines(&columns);
+				if (relabel_if_smaller(grid, size, rows, columns, &candidate, &numbers, canonical->cells))
+				{
+					canonical->cells = candidate;
+					canonical->transposed = transposed != 0;
+					canonical->rows = rows;
+					canonical->columns = columns;
+					canonical->numbers = numbers;
+				}
+			} while (enumerate && column_order.next());
+		} while (enumerate && row_order.next());
+	}
+
+	//numbers that aren't given get the remaining canonical numbers, any order works for them
+	auto next_number = 1 + *std::max_element(canonical->numbers.begin(), canonical->numbers.end());
+	for (auto number = 1; number <= size; ++number)
+		if (!canonical->numbers[number]) canonical->numbers[number] = next_number++;
+}
+
+std::vector<int> CanonicalSudoku::to_canonical(const std::vector<int>& original) const
+{
+	std::vector<int> result(original.size());
+	for (auto i = 0; i < size; ++i)
+	{
+		for (auto j = 0; j < size; ++j)
+		{
+			const auto cell = transposed ? std::size_t(columns[j]) * size + rows[i] : std::size_t(rows[i]) * size + columns[j];
+			result[std::size_t(i) * size + j] = numbers[original[cell]];
+		}
+	}
+	return result;
+}
+
+std::vector<int> CanonicalSudoku::to_original(const std::vector<int>& canonical_cells) const
+{
+	std::vector<int> original_numbers(numbers.size());
+	for (std::size_t number = 0; number < numbers.size(); ++number) original_numbers[numbers[number]] = int(number);
+
+	std::vector<int> result(canonical_cells.size());
+	for (auto i = 0; i < size; ++i)
+	{
+		for (auto j = 0; j < size; ++j)
+		{
+			const auto cell = transposed ? std::size_t(columns[j]) * size + rows[i] : std::size_t(rows[i]) * size + columns[j];
+			result[cell] = original_numbers[canonical_cells[std::size_t(i) * size + j]];
+		}
+	}
+	return result;
+}
+
+SolutionCache::SolutionCache(const std::string& path) : mPath(path)
+{
+	if (mPath.empty()) return;
+
+	mFile = open(mPath.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (mFile == -1)
+	{
+		std::cerr << "Couldn't open the cache \"" << mPath << "\", only caching in memory." << std::endl;
+		return;
+	}
+
+	read_file();
+}
+
+SolutionCache::~SolutionCache()
+{
+	if (mFile != -1) close(mFile);
+}
+
+void SolutionCache::read_file()
+{
+	struct stat status;
+	if (fstat(mFile, &status) == -1) return;
+
+	const auto length = std::size_t(status.st_size);
+	if (length == 0)
+	{
+		if (write(mFile, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) != sizeof(CACHE_FILE_MAGIC)) std::cerr << "Couldn't write the cache." << std::endl;
+		return;
+	}
+
+	const auto mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (mapping == MAP_FAILED) return;
+
+	const auto data = static_cast<const char*>(mapping);
+	if (length < sizeof(CACHE_FILE_MAGIC) || std::memcmp(data, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) != 0)
+	{
+		std::cerr << "\"" << mPath << "\" is no cache, only caching in memory." << std::endl;
+		munmap(mapping, length);
+		close(mFile);
+		mFile = -1;
+		return;
+	}
+
+	auto position = sizeof(CACHE_FILE_MAGIC);
+	auto damaged = 0;
+	while (position + 2 * sizeof(std::uint32_t) <= length)
+	{
+		std::uint32_t key_length, solution_length;
+		std::memcpy(&key_length, data + position, sizeof(key_length));
+		std::memcpy(&solution_length, data + position + sizeof(key_length), sizeof(solution_length));
+		position += 2 * sizeof(std::uint32_t);
+
+		if (position + key_length + solution_length > length) break;
+
+		//the key and the solution both hold the size and every cell, lookup() relies on that
+		const auto size = key_length >= 2 ? std::size_t(std::uint8_t(data[position]) | (std::uint8_t(data[position + 1]) << 8)) : 0;
+		if (key_length != 2 * (size * size + 1) || solution_length != key_length)
+		{
+			position += key_length + solution_length;
+			++damaged;
+			continue;
+		}
+
+		mEntries.emplace(std::string(data + position, key_length), std::string(data + position + key_length, solution_length));
+		position += key_length + solution_length;
+		++mLoaded;
+	}
+
+	if (damaged) std::cerr << "Skipped " << damaged << " damaged entries of the cache \"" << mPath << "\"." << std::endl;
+	munmap(mapping, length);
+}
+
+//two bytes for the size and every cell
+std::string SolutionCache::get_key(const std::vector<int>& cells, const int size)
+{
+	std::string key;
+	key.reserve(2 * (cells.size() + 1));
+	key += char(size & 0xff);
+	key += char(size >> 8);
+	for (auto number : cells)
+	{
+		key += char(number & 0xff);
+		key += char(number >> 8);
+	}
+	return key;
+}
+
+bool SolutionCache::lookup(const std::vector<int>& cells, const int size, CanonicalSudoku* canonical, std::vector<int>* solution)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	canonicalize(cells, size, canonical);
+	const auto key = get_key(canonical->cells, size);
+
+	std::string value;
+	bool hit;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const auto entry = mEntries.find(key);
+		hit = entry != mEntries.end() && entry->second.size() == 2 * (cells.size() + 1);
+		if (hit) value = entry->second;
+	}
+
+	if (hit)
+	{
+		std::vector<int> canonical_solution(cells.size());
+		for (std::size_t cell = 0; cell < canonical_solution.size(); ++cell)
+			canonical_solution[cell] = std::uint8_t(value[2 * (cell + 1)]) | (std::uint8_t(value[2 * (cell + 1) + 1]) << 8);
+		*solution = canonical->to_original(canonical_solution);
+	}
+
+	const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	++mLookups;
+	if (hit)
+	{
+		++mHits;
+		mHit_seconds += seconds;
+	}
+	else
+	{
+		mMiss_seconds += seconds;
+	}
+
+	return hit;
+}
+
+void SolutionCache::add(const CanonicalSudoku& canonical, const std::vector<int>& solution)
+{
+	auto key = get_key(canonical.cells, canonical.size);
+	auto value = get_key(canonical.to_canonical(solution), canonical.size);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	const auto inserted = mEntries.emplace(key, value).second;
+	if (!inserted || mFile == -1) return;
+
+	//one write per entry, so processes sharing the file don't mix their entries
+	const std::uint32_t lengths[2] = {std::uint32_t(key.size()), std::uint32_t(value.size())};
+	std::string record(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+	record += key;
+	record += value;
+	if (write(mFile, record.data(), record.size()) != ssize_t(record.size()))
+		std::cerr << "Couldn't write the cache." << std::endl;
+}
+
+void SolutionCache::print_statistics(std::ostream& stream)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	const auto misses = mLookups - mHits;
+	stream << "Cache: " << mLookups << " lookups, " << mHits << " hits ("
+		   << (mLookups ? 100. * mHits / mLookups : 0.) << "%), a hit took " << (mHits ? mHit_seconds / mHits * 1000 : 0.)
+		   << " ms, a miss " << (misses ? mMiss_seconds / misses * 1000 : 0.) << " ms on average, "
+		   << mEntries.size() << " entries (" << mLoaded << " from the file)" << std::endl;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//a sudoku in the canonical form of its symmetry class and the transformation that leads there
+//the symmetries are relabelling the numbers, transposing and permuting bands, stacks and the rows and columns inside them
+//the form is the smallest sudoku (row by row, relabelled by first appearance) over the row and column orders the
+//invariants of the rows and columns allow, if too many orders tie the original one breaks the tie,
+//then some equivalent sudokus get different forms, which only costs hits
+struct CanonicalSudoku
+{
+	int size = 0;
+	std::vector<int> cells;			//the canonical sudoku, row by row, 0 is empty
+	bool transposed = false;
+	std::vector<int> rows;			//canonical row i is row rows[i] of the (transposed) sudoku
+	std::vector<int> columns;		//the same for the columns
+	std::vector<int> numbers;		//number of the sudoku -> canonical number, both 1 based, numbers[0] is 0
+
+	//maps cells of the sudoku to the canonical form and back, used for the solutions
+	std::vector<int> to_canonical(const std::vector<int>& cells) const;
+	std::vector<int> to_original(const std::vector<int>& canonical_cells) const;
+};
+
+//computes the canonical form of the sudoku given row by row
+void canonicalize(const std::vector<int>& cells, int size, CanonicalSudoku* canonical);
+
+//maps the canonical form of solved sudokus to their solution, so a sudoku equivalent to a solved one is answered
+//without preprocessing, encoding or solver
+//with a path the entries are also appended to that file and the ones in it are read with mmap on construction,
+//so the cache survives the process and can be shared by several of them
+class SolutionCache
+{
+public:
+	explicit SolutionCache(const std::string& path = "");
+	~SolutionCache();
+
+	SolutionCache(const SolutionCache&) = delete;
+	SolutionCache& operator=(const SolutionCache&) = delete;
+
+	//computes the canonical form of the sudoku and returns true if a solution for it is known, the solution is for the sudoku itself
+	bool lookup(const std::vector<int>& cells, int size, CanonicalSudoku* canonical, std::vector<int>* solution);
+
+	//stores the solution of the sudoku whose canonical form was computed by lookup()
+	void add(const CanonicalSudoku& canonical, const std::vector<int>& solution);
+
+	//lookups, hits, hit rate and the average time of a hit and a miss
+	void print_statistics(std::ostream& stream);
+
+private:
+	static std::string get_key(const std::vector<int>& cells, int size);
+
+	//reads the entries of the file, a half written entry at the end is ignored
+	void read_file();
+
+	std::mutex mMutex;
+	std::unordered_map<std::string, std::string> mEntries;		//key of the canonical sudoku -> key of its canonical solution
+
+	std::string mPath;
+	int mFile = -1;
+
+	std::uint64_t mLookups = 0;
+	std::uint64_t mHits = 0;
+	double mHit_seconds = 0;
+	double mMiss_seconds = 0;
+	std::uint64_t mLoaded = 0;		//entries read from the file
+};
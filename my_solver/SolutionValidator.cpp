@@ -0,0 +1,52 @@
+#include "pch.h"
+#include "SolutionValidator.h"
+#include <algorithm>
+#include <cmath>
+
+SolutionValidator::SolutionValidator(const int size) :
+	mSize(size), mN(int(std::lround(std::sqrt(size)))), mWords((size + 63) / 64),
+	mRows(std::size_t(size) * mWords), mColumns(std::size_t(size) * mWords), mBoxes(std::size_t(size) * mWords)
+{
+}
+
+bool SolutionValidator::check(const int* cells, const int* givens)
+{
+	std::fill(mRows.begin(), mRows.end(), 0);
+	std::fill(mColumns.begin(), mColumns.end(), 0);
+	std::fill(mBoxes.begin(), mBoxes.end(), 0);
+
+	for (auto y = 0; y < mSize; ++y)
+	{
+		const auto row = cells + std::size_t(y) * mSize;
+		const auto given_row = givens ? givens + std::size_t(y) * mSize : nullptr;
+		const auto box_row = y / mN * mN;
+
+		for (auto x = 0; x < mSize; ++x)
+		{
+			const auto number = row[x] - 1;
+			if (number < 0 || number >= mSize) return false;
+			if (given_row && given_row[x] && given_row[x] != row[x]) return false;
+
+			const auto word = number / 64;
+			const auto bit = std::uint64_t(1) << (number % 64);
+
+			//a number seen before in any of the three units is a duplicate
+			auto& row_mask = mRows[std::size_t(y) * mWords + word];
+			auto& column_mask = mColumns[std::size_t(x) * mWords + word];
+			auto& box_mask = mBoxes[std::size_t(box_row + x / mN) * mWords + word];
+			if ((row_mask | column_mask | box_mask) & bit) return false;
+
+			row_mask |= bit;
+			column_mask |= bit;
+			box_mask |= bit;
+		}
+	}
+
+	//size cells without a duplicate hold every number once
+	return true;
+}
+
+int SolutionValidator::get_size() const
+{
+	return mSize;
+}
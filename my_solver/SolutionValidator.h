@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//checks solved sudokus with a bitmask of the numbers seen in every row, column and box
+//a validator is made for one size and keeps its masks, so checking many sudokus doesn't allocate
+class SolutionValidator
+{
+public:
+	explicit SolutionValidator(int size);
+
+	//true if every cell holds a number from 1 to size, every number is once in each row, column and box
+	//and, if givens isn't null, every given number (0 is empty) is kept, all row by row
+	bool check(const int* cells, const int* givens);
+
+	int get_size() const;
+
+private:
+	int mSize;
+	int mN;
+	int mWords;						//64 bit words of a mask
+	std::vector<std::uint64_t> mRows;
+	std::vector<std::uint64_t> mColumns;
+	std::vector<std::uint64_t> mBoxes;
+};
@@ -0,0 +1,258 @@
+#include "pch.h"
+#include "SolveServer.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//writes everything, a client that went away is not an error of the server
+static bool write_all(const int output, const std::string& data, const bool is_socket)
+{
+	std::size_t written = 0;
+	while (written < data.size())
+	{
+		const auto result = is_socket ? send(output, data.data() + written, data.size() - written, MSG_NOSIGNAL)
+									  : write(output, data.data() + written, data.size() - written);
+		if (result == -1 && errno == EINTR) continue;
+		if (result <= 0) return false;
+		written += result;
+	}
+	return true;
+}
+
+SolveServer::SolveServer(const std::string& solver, const EncodingOptions& encoding_options, const ParallelOptions& parallel_options,
+						 const bool verbose, SolutionCache* cache) :
+	mSolver(solver), mAdapter(SolverAdapter::get(solver)), mEncoding_options(encoding_options), mParallel_options(parallel_options),
+	mVerbose(verbose), mCache(cache)
+{
+}
+
+SolveServer::~SolveServer()
+{
+	if (mParallel_options.memory_scratch) return;
+
+	//every slot is free again once the server goes away
+	for (const auto& size : mFree_slots)
+	{
+		for (const auto& slot : size.second)
+		{
+			std::remove((slot->prefix + "model.txt").c_str());
+			std::remove((slot->prefix + "temp_clauses.txt").c_str());
+			std::remove((slot->prefix + "clauses_out.cnf").c_str());
+		}
+	}
+}
+
+std::unique_ptr<SolveServer::Slot> SolveServer::acquire(const int size)
+{
+	std::unique_ptr<Slot> slot;
+	std::string prefix;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto& free_slots = mFree_slots[size];
+		if (!free_slots.empty())
+		{
+			slot = std::move(free_slots.back());
+			free_slots.pop_back();
+			return slot;
+		}
+		prefix = get_process_prefix("serve") + std::to_string(mNext_slot++) + "_";
+	}
+
+	slot.reset(new Slot);
+	slot->prefix = prefix;
+	slot->sudoku.reset(new Sudoku(size, false));
+
+	const auto in_memory = mParallel_options.memory_scratch;
+	slot->model_path = get_scratch_path(prefix + "model.txt", in_memory, &slot->scratch_files);
+	slot->sudoku->set_scratch_files(get_scratch_path(prefix + "temp_clauses.txt", in_memory, &slot->scratch_files),
+									get_scratch_path(prefix + "clauses_out.cnf", in_memory, &slot->scratch_files));
+
+	if (mVerbose) std::cerr << "Created a " << size << "x" << size << " slot." << std::endl;
+	return slot;
+}
+
+void SolveServer::release(std::unique_ptr<Slot> slot)
+{
+	const auto size = slot->sudoku->get_size();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFree_slots[size].push_back(std::move(slot));
+}
+
+std::string SolveServer::handle(const std::string& request)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	if (request == "stats")
+	{
+		if (!mCache) return "error no cache";
+
+		std::stringstream statistics;
+		mCache->print_statistics(statistics);
+		auto line = "stats " + statistics.str();
+		line.pop_back();
+		return line;
+	}
+
+	std::vector<int> cells;
+	int size;
+	if (!parse_sudoku_line(request, &cells, &size)) return "error not a sudoku";
+
+	std::vector<int> solution;
+	auto solver_seconds = 0.;
+	const auto status = solve(cells, size, &solution, &solver_seconds);
+
+	std::stringstream answer;
+	if (status == SolveStatus::solved) answer << "solved " << format_sudoku_line(solution, size) << " ";
+	else answer << (status == SolveStatus::unsolvable ? "unsolvable " : "unknown ");
+	answer << seconds_since(start) << " " << solver_seconds;
+	return answer.str();
+}
+
+SolveStatus SolveServer::solve(const std::vector<int>& cells, const int size, std::vector<int>* solution, double* solver_seconds)
+{
+	*solver_seconds = 0;
+
+	CanonicalSudoku canonical;
+	if (mCache && mCache->lookup(cells, size, &canonical, solution)) return SolveStatus::solved;
+
+	auto slot = acquire(size);
+	auto& sudoku = *slot->sudoku;
+
+	if (!sudoku.load(cells) || !sudoku.is_solvable())
+	{
+		release(std::move(slot));
+		return SolveStatus::unsolvable;
+	}
+
+	sudoku.simple_solve();
+
+	//the preprocessing alone solves many of the small ones, then there's nothing to start a solver for
+	auto solved = sudoku.is_solvable() && sudoku.get_solved_fields() == size * size;
+	auto status = sudoku.is_solvable() ? SolveStatus::unknown : SolveStatus::unsolvable;
+
+	if (sudoku.is_solvable() && !solved)
+	{
+		sudoku.set_encoding_options(mEncoding_options);
+		sudoku.create_lut();
+		sudoku.generate_all_clauses();
+		sudoku.write_clauses();
+
+		const auto solver_start = std::chrono::steady_clock::now();
+
+		int result;
+		struct rusage usage{};
+		double cpu_seconds;
+		const auto solved_by = run_solvers_until_answer(mAdapter, {sudoku.get_clauses_filename()}, {slot->model_path}, 1, true,
+														&result, &usage, &cpu_seconds, mParallel_options.limits);
+		*solver_seconds = seconds_since(solver_start);
+
+		if (solved_by != -1 && result == 1)
+		{
+			sudoku.read_solution(slot->model_path, mAdapter.format);
+			solved = sudoku.get_solved_fields() == size * size;
+		}
+		else if (solved_by != -1)
+		{
+			status = SolveStatus::unsolvable;
+		}
+	}
+
+	if (solved)
+	{
+		sudoku.get_cells(solution);
+		if (mCache) mCache->add(canonical, *solution);
+		status = SolveStatus::solved;
+	}
+
+	release(std::move(slot));
+	return status;
+}
+
+void SolveServer::serve_stream(const int input, const int output, const bool is_socket)
+{
+	std::string pending;
+	char buffer[1 << 16];
+
+	while (true)
+	{
+		const auto count = read(input, buffer, sizeof(buffer));
+		if (count == -1 && errno == EINTR) continue;
+
+		//the end of the input also ends a last line without newline
+		if (count <= 0 && pending.empty()) return;
+		if (count <= 0) pending += '\n';
+		else pending.append(buffer, count);
+
+		std::size_t line_start = 0;
+		for (auto newline = pending.find('\n'); newline != std::string::npos; newline = pending.find('\n', line_start))
+		{
+			auto request = pending.substr(line_start, newline - line_start);
+			line_start = newline + 1;
+
+			if (!request.empty() && request.back() == '\r') request.pop_back();
+			if (request.empty() || request[0] == '#') continue;
+
+			if (!write_all(output, handle(request) + "\n", is_socket)) return;
+		}
+		pending.erase(0, line_start);
+
+		if (count <= 0) return;
+	}
+}
+
+bool SolveServer::serve_socket(const std::string& path)
+{
+	struct sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << "Socket path \"" << path << "\" is too long." << std::endl;
+		return false;
+	}
+	path.copy(address.sun_path, path.size());
+
+	const auto server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (server == -1) return false;
+
+	//a socket left behind by an earlier server is replaced
+	unlink(path.c_str());
+
+	if (bind(server, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == -1 || listen(server, SOMAXCONN) == -1)
+	{
+		std::cerr << "Couldn't listen on \"" << path << "\"." << std::endl;
+		close(server);
+		return false;
+	}
+
+	std::cerr << "Listening on " << path << std::endl;
+
+	while (true)
+	{
+		const auto client = accept4(server, nullptr, nullptr, SOCK_CLOEXEC);
+		if (client == -1)
+		{
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			break;
+		}
+
+		std::thread([this, client]() {
+			serve_stream(client, client, true);
+			close(client);
+		}).detach();
+	}
+
+	close(server);
+	return false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Sudoku.h"
+
+//what became of a sudoku given to SolveServer::solve()
+enum class SolveStatus
+{
+	solved,
+	unsolvable,
+	unknown			//the solver hit a limit
+};
+
+//keeps the process resident and solves sudokus sent as single lines, see parse_sudoku_line()
+//every request gets exactly one line back:
+//	solved <cells> <seconds> <solver seconds>
+//	unsolvable <seconds> <solver seconds>
+//	unknown <seconds> <solver seconds>		if the solver hit a limit
+//	error <message>
+//the request "stats" is answered with the statistics of the cache
+//the sudokus and their scratch files are kept in a pool per size and reused, the solver is only started
+//if the preprocessing doesn't already fill the whole sudoku
+class SolveServer
+{
+public:
+	SolveServer(const std::string& solver, const EncodingOptions& encoding_options, const ParallelOptions& parallel_options, bool verbose,
+				SolutionCache* cache = nullptr);
+
+	//deletes the scratch files of the slots if they are on the disk
+	~SolveServer();
+
+	//answers the requests on the input until it ends
+	void serve_stream(int input, int output, bool is_socket);
+
+	//listens on a unix domain socket, every connection is served by a thread of its own, only returns on an error
+	bool serve_socket(const std::string& path);
+
+	//solves one request and returns the answer without the newline
+	std::string handle(const std::string& request);
+
+	//solves the sudoku given row by row, solution gets the cells if it is solved, can be called from several threads at once
+	//this is also how a corpus is solved, see solve_corpus()
+	SolveStatus solve(const std::vector<int>& cells, int size, std::vector<int>* solution, double* solver_seconds);
+
+private:
+	//a sudoku of one size together with the files its cnf and model live in
+	struct Slot
+	{
+		std::unique_ptr<Sudoku> sudoku;
+		std::vector<ScratchFile> scratch_files;
+		std::string prefix;			//of the scratch files
+		std::string model_path;
+	};
+
+	//takes a free slot of the size or creates one, release() puts it back
+	std::unique_ptr<Slot> acquire(int size);
+	void release(std::unique_ptr<Slot> slot);
+
+	std::string mSolver;
+	SolverAdapter mAdapter;
+	EncodingOptions mEncoding_options;
+	ParallelOptions mParallel_options;
+	bool mVerbose;
+	SolutionCache* mCache;
+
+	std::mutex mMutex;
+	std::map<int, std::vector<std::unique_ptr<Slot>>> mFree_slots;
+	int mNext_slot = 0;		//numbers the scratch files of the slots
+};
@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "SolverAdapter.h"
+#include <fstream>
+
+//every solver this encoder knows how to run, the executable is filled in by find()
+static const SolverAdapter SOLVER_ADAPTERS[] = {
+	{"clasp", "{cnf}", SolverInput::path, true, ModelFormat::competition, ""},
+	{"kissat", "", SolverInput::standard_input, true, ModelFormat::competition, ""},
+	{"glucose", "{cnf} {model}", SolverInput::path, false, ModelFormat::minisat, ""},		//glucose only prints the model to a file
+	{"minisat", "{cnf} {model}", SolverInput::path, false, ModelFormat::minisat, ""}
+};
+
+static void replace_all(std::string* text, const std::string& from, const std::string& to)
+{
+	for (auto position = text->find(from); position != std::string::npos; position = text->find(from, position + to.size()))
+		text->replace(position, from.size(), to);
+}
+
+std::string SolverAdapter::get_command(const std::string& cnf_path, const std::string& model_path) const
+{
+	auto command_arguments = arguments;
+	replace_all(&command_arguments, "{cnf}", cnf_path);
+	replace_all(&command_arguments, "{model}", model_path);
+
+	auto command = executable;
+	if (!command_arguments.empty()) command += " " + command_arguments;
+	if (input == SolverInput::standard_input) command += " < " + cnf_path;
+
+	return command;
+}
+
+std::string SolverAdapter::get_stdout_path(const std::string& model_path) const
+{
+	return model_on_stdout ? model_path : "/dev/null";
+}
+
+int SolverAdapter::read_status(const std::string& model_path) const
+{
+	std::ifstream file(model_path);
+	std::string content;
+
+	while (std::getline(file, content))
+	{
+		if (format == ModelFormat::minisat)
+		{
+			//only the first line has the status
+			if (content == "SAT") return 1;
+			if (content == "UNSAT") return 0;
+			return -1;
+		}
+
+		if (content.rfind("s SATISFIABLE", 0) == 0) return 1;
+		if (content.rfind("s UNSATISFIABLE", 0) == 0) return 0;
+	}
+
+	return -1;
+}
+
+bool SolverAdapter::find(const std::string& solver, SolverAdapter* adapter)
+{
+	//the solver can be given with a path, the adapter is chosen by the name of the executable
+	const auto slash = solver.rfind('/');
+	const auto name = slash == std::string::npos ? solver : solver.substr(slash + 1);
+
+	for (const auto& known : SOLVER_ADAPTERS)
+	{
+		if (known.name != name) continue;
+
+		*adapter = known;
+		adapter->executable = solver;
+		return true;
+	}
+
+	return false;
+}
+
+SolverAdapter SolverAdapter::get(const std::string& solver)
+{
+	SolverAdapter adapter;
+	if (!find(solver, &adapter))
+	{
+		//unknown solvers are treated like clasp
+		adapter = SOLVER_ADAPTERS[0];
+		adapter.name = solver;
+		adapter.executable = solver;
+	}
+	return adapter;
+}
+
+std::vector<std::string> SolverAdapter::get_names()
+{
+	std::vector<std::string> names;
+	for (const auto& known : SOLVER_ADAPTERS) names.push_back(known.name);
+	return names;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//how a solver gets the cnf
+enum class SolverInput
+{
+	path,				//as a path on the commandline, that can also be a /proc/<pid>/fd path of a ScratchFile
+	standard_input		//piped into stdin
+};
+
+//layout of the model the solver writes
+enum class ModelFormat
+{
+	competition,		//sat competition: "s SATISFIABLE" and the literals on "v" lines
+	minisat				//first line SAT, UNSAT or INDET, the literals on the following lines
+};
+
+//describes how to run one solver and how to read its answer
+struct SolverAdapter
+{
+	std::string name;
+	std::string arguments;				//{cnf} and {model} are replaced by the paths
+	SolverInput input;
+	bool model_on_stdout;				//false if the solver writes the model to the file given as {model}
+	ModelFormat format;
+
+	std::string executable;				//what was given on the commandline, might include a path
+
+	//the command to run, without a redirection of stdout
+	std::string get_command(const std::string& cnf_path, const std::string& model_path) const;
+
+	//where stdout of the command has to go, the model itself or nowhere
+	std::string get_stdout_path(const std::string& model_path) const;
+
+	//reads the answer of the solver in the model file, returns 1 for satisfiable, 0 for unsatisfiable and -1 if there is none
+	int read_status(const std::string& model_path) const;
+
+	//finds the adapter for a solver by the name of its executable, returns false if there is none
+	static bool find(const std::string& solver, SolverAdapter* adapter);
+
+	//the adapter for a solver that was already checked with find()
+	static SolverAdapter get(const std::string& solver);
+
+	//names of all known solvers
+	static std::vector<std::string> get_names();
+};
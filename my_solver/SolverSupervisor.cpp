@@ -0,0 +1,340 @@
+#include "pch.h"
+#include "SolverSupervisor.h"
+#include "Sudoku.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <csignal>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//how often the exits are polled if the kernel has no pidfd
+const int EXIT_POLL_MILLISECONDS = 20;
+
+//how long a stopped solver gets to exit on SIGTERM before it is killed
+const double STOP_GRACE_SECONDS = 2;
+
+static double now_seconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//epoll data of a job: the index and whether the event is from the pipe or the pidfd
+static std::uint64_t event_data(const int job, const bool is_pidfd)
+{
+	return (std::uint64_t(job) << 1) | (is_pidfd ? 1 : 0);
+}
+
+SolverSupervisor::SolverSupervisor(const int max_running, const SolverLimits& limits) :
+	mMax_running(max_running > 0 ? max_running : 1), mLimits(limits)
+{
+}
+
+int SolverSupervisor::add(const std::string& command, const std::string& output_path)
+{
+	SupervisedJob job;
+	job.command = command;
+	job.output_path = output_path;
+	mJobs.push_back(job);
+	return int(mJobs.size()) - 1;
+}
+
+const SupervisedJob& SolverSupervisor::get_job(const int job) const
+{
+	return mJobs[job];
+}
+
+int SolverSupervisor::get_number_of_jobs() const
+{
+	return int(mJobs.size());
+}
+
+bool SolverSupervisor::launch(const int index)
+{
+	auto& job = mJobs[index];
+
+	job.output_file = open(job.output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (job.output_file == -1)
+	{
+		std::cerr << "Couldn't open solver output \"" << job.output_path << "\"." << std::endl;
+		return false;
+	}
+
+	int pipe_ends[2];
+	if (pipe2(pipe_ends, O_CLOEXEC) == -1)
+	{
+		close(job.output_file);
+		return false;
+	}
+
+	//everything the child needs is prepared before the fork
+	const auto shell_command = "exec " + job.command;
+	const auto cpu_limit = mLimits.cpu_seconds;
+
+	job.start = now_seconds();
+	const auto pid = fork_command_process();
+
+	if (pid < 0)
+	{
+		std::cout << "Failed to fork!" << std::endl;
+		close(pipe_ends[0]);
+		close(pipe_ends[1]);
+		close(job.output_file);
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		//child
+		dup2(pipe_ends[1], STDOUT_FILENO);
+
+		if (cpu_limit > 0)
+		{
+			//the kernel sends SIGXCPU at the soft limit and kills at the hard one
+			struct rlimit limit;
+			limit.rlim_cur = cpu_limit;
+			limit.rlim_max = cpu_limit + 1;
+			setrlimit(RLIMIT_CPU, &limit);
+		}
+
+		execl("/bin/sh", "sh", "-c", shell_command.c_str(), static_cast<char*>(nullptr));
+		_exit(127);
+	}
+
+	setpgid(pid, pid);
+	track_command(pid);
+
+	close(pipe_ends[1]);
+	fcntl(pipe_ends[0], F_SETFL, fcntl(pipe_ends[0], F_GETFL) | O_NONBLOCK);
+
+	job.pid = pid;
+	job.output_pipe = pipe_ends[0];
+	job.output_open = true;
+
+	struct epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.u64 = event_data(index, false);
+	epoll_ctl(mEpoll, EPOLL_CTL_ADD, job.output_pipe, &event);
+
+	if (mPidfd_supported)
+	{
+#ifdef SYS_pidfd_open
+		job.pidfd = int(syscall(SYS_pidfd_open, pid, 0));
+#endif
+		if (job.pidfd == -1)
+		{
+			//older kernel, fall back to polling
+			mPidfd_supported = false;
+		}
+		else
+		{
+			event.data.u64 = event_data(index, true);
+			epoll_ctl(mEpoll, EPOLL_CTL_ADD, job.pidfd, &event);
+		}
+	}
+
+	mRunning.push_back(index);
+	return true;
+}
+
+bool SolverSupervisor::forward_output(SupervisedJob* job)
+{
+	char buffer[1 << 16];
+
+	while (true)
+	{
+		const auto count = read(job->output_pipe, buffer, sizeof(buffer));
+		if (count > 0)
+		{
+			auto written = 0l;
+			while (written < count)
+			{
+				const auto result = write(job->output_file, buffer + written, count - written);
+				if (result <= 0) break;
+				written += result;
+			}
+			continue;
+		}
+
+		if (count == -1 && errno == EINTR) continue;
+		if (count == -1 && errno == EAGAIN) return true;
+
+		//end of the output
+		epoll_ctl(mEpoll, EPOLL_CTL_DEL, job->output_pipe, nullptr);
+		close(job->output_pipe);
+		job->output_open = false;
+		return false;
+	}
+}
+
+bool SolverSupervisor::try_reap(const int index)
+{
+	auto& job = mJobs[index];
+
+	int status;
+	const auto pid = wait4(job.pid, &status, WNOHANG, &job.usage);
+	if (pid != job.pid) return false;
+
+	job.wall_seconds = now_seconds() - job.start;
+	untrack_command(job.pid);
+
+	//the child is traced from its launch to its exit, the times of the job are steady clock seconds as well
+	if (trace_enabled.load(std::memory_order_relaxed))
+		add_trace_event("solver", "solver", std::int64_t(job.start * 1e9), get_trace_time(), job.pid);
+
+	//whatever the solver wrote last is still in the pipe, anything it started and that still holds the pipe is ignored
+	if (job.output_open) forward_output(&job);
+	if (job.output_open)
+	{
+		epoll_ctl(mEpoll, EPOLL_CTL_DEL, job.output_pipe, nullptr);
+		close(job.output_pipe);
+		job.output_open = false;
+	}
+	close(job.output_file);
+
+	if (job.pidfd != -1)
+	{
+		epoll_ctl(mEpoll, EPOLL_CTL_DEL, job.pidfd, nullptr);
+		close(job.pidfd);
+		job.pidfd = -1;
+	}
+
+	if (WIFEXITED(status))
+	{
+		job.exit_code = WEXITSTATUS(status);
+	}
+	else if (WIFSIGNALED(status))
+	{
+		const auto signal = WTERMSIG(status);
+		const auto cpu_seconds = job.usage.ru_utime.tv_sec + job.usage.ru_stime.tv_sec;
+		if (mLimits.cpu_seconds > 0 && (signal == SIGXCPU || (signal == SIGKILL && cpu_seconds >= mLimits.cpu_seconds)))
+			job.cpu_limit_exceeded = true;
+	}
+
+	return true;
+}
+
+void SolverSupervisor::kill_job(const int index, const int signal)
+{
+	kill(-mJobs[index].pid, signal);
+}
+
+void SolverSupervisor::abort_running()
+{
+	for (auto index : mRunning)
+	{
+		mJobs[index].stopped = true;
+		kill_job(index, SIGKILL);
+	}
+
+	for (auto index : mRunning)
+		while (!try_reap(index)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	mRunning.clear();
+}
+
+void SolverSupervisor::run(const std::function<bool(int job)>& on_finish)
+{
+	mEpoll = epoll_create1(EPOLL_CLOEXEC);
+
+	auto next = 0;
+	auto stopping = false;
+	struct epoll_event events[64];
+
+	while ((!stopping && next < int(mJobs.size())) || !mRunning.empty())
+	{
+		//keep max_running solvers busy
+		while (!stopping && next < int(mJobs.size()) && int(mRunning.size()) < mMax_running)
+		{
+			if (!launch(next))
+			{
+				mJobs[next].launch_failed = true;
+				if (on_finish(next)) stopping = true;
+			}
+			++next;
+		}
+
+		if (mRunning.empty()) continue;
+
+		//sleep until output arrives, a solver exits or the next wall limit or kill of a stopped solver is due
+		auto timeout = -1;
+		if (!mPidfd_supported) timeout = EXIT_POLL_MILLISECONDS;
+		const auto now = now_seconds();
+		const auto wake_at = [&timeout, now](const double time) {
+			const auto remaining = int((time - now) * 1000) + 1;
+			timeout = timeout == -1 ? std::max(remaining, 0) : std::max(std::min(timeout, remaining), 0);
+		};
+		for (auto index : mRunning)
+		{
+			if (mLimits.wall_seconds > 0 && !mJobs[index].wall_limit_exceeded) wake_at(mJobs[index].start + mLimits.wall_seconds);
+			if (mJobs[index].kill_time > 0) wake_at(mJobs[index].kill_time);
+		}
+
+		const auto count = epoll_wait(mEpoll, events, 64, timeout);
+		if (count == -1 && errno != EINTR)
+		{
+			std::cerr << "Watching the solvers failed: " << std::strerror(errno) << ", killing them." << std::endl;
+			abort_running();
+			break;
+		}
+
+		for (auto i = 0; i < count; ++i)
+		{
+			auto& job = mJobs[events[i].data.u64 >> 1];
+			if (!(events[i].data.u64 & 1) && job.output_open) forward_output(&job);
+		}
+
+		//collect every solver that exited, a pidfd only tells that one did
+		for (auto position = 0; position < int(mRunning.size());)
+		{
+			const auto index = mRunning[position];
+			if (!try_reap(index))
+			{
+				++position;
+				continue;
+			}
+
+			mRunning.erase(mRunning.begin() + position);
+
+			if (mJobs[index].stopped) continue;
+			if (on_finish(index) && !stopping)
+			{
+				//this job decided the run, stop the others
+				stopping = true;
+				for (auto running : mRunning)
+				{
+					mJobs[running].stopped = true;
+					mJobs[running].kill_time = now_seconds() + STOP_GRACE_SECONDS;
+					kill_job(running, SIGTERM);
+				}
+			}
+		}
+
+		//enforce the wall limit and kill the stopped solvers that ignored SIGTERM
+		const auto after = now_seconds();
+		for (auto index : mRunning)
+		{
+			auto& job = mJobs[index];
+			if (mLimits.wall_seconds > 0 && !job.wall_limit_exceeded && after - job.start >= mLimits.wall_seconds)
+			{
+				job.wall_limit_exceeded = true;
+				kill_job(index, SIGKILL);
+			}
+			if (job.kill_time > 0 && after >= job.kill_time)
+			{
+				job.kill_time = 0;
+				kill_job(index, SIGKILL);
+			}
+		}
+	}
+
+	close(mEpoll);
+	mEpoll = -1;
+}
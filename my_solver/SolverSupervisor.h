@@ -0,0 +1,77 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+//limits for every single solver run, 0 means no limit
+struct SolverLimits
+{
+	double wall_seconds = 0;
+	int cpu_seconds = 0;
+};
+
+//a solver run watched by the supervisor
+struct SupervisedJob
+{
+	std::string command;
+	std::string output_path;		//receives everything the solver writes to stdout
+
+	//filled in when the job finished
+	int exit_code = -1;				//-1 if the solver was killed by a signal or never started
+	bool launch_failed = false;		//the output, the pipe or the fork failed, nothing the solver wrote belongs to this run
+	bool wall_limit_exceeded = false;
+	bool cpu_limit_exceeded = false;
+	bool stopped = false;			//killed because another job decided the run
+	double kill_time = 0;			//when a stopped job that ignores SIGTERM gets SIGKILL, 0 if none is due
+	double wall_seconds = 0;
+	struct rusage usage{};
+
+	pid_t pid = -1;
+	int output_pipe = -1;
+	int output_file = -1;
+	int pidfd = -1;
+	bool output_open = false;
+	double start = 0;
+};
+
+//event loop that runs up to max_running solvers at the same time without a thread per solver
+//the output pipes and the exits of the solvers (through pidfds) are watched with epoll,
+//on kernels without pidfd the exits are polled instead
+class SolverSupervisor
+{
+public:
+	SolverSupervisor(int max_running, const SolverLimits& limits);
+
+	//queues a solver run, returns its index
+	int add(const std::string& command, const std::string& output_path);
+
+	//runs the queued jobs, on_finish is called for every finished job and can return true to stop the other jobs
+	void run(const std::function<bool(int job)>& on_finish);
+
+	const SupervisedJob& get_job(int job) const;
+	int get_number_of_jobs() const;
+
+private:
+	bool launch(int job);
+
+	//reads what's available from the output pipe, returns false once the pipe is closed
+	bool forward_output(SupervisedJob* job);
+
+	//checks if the job has exited, collects its status and usage
+	bool try_reap(int job);
+
+	void kill_job(int job, int signal);
+
+	//kills the running jobs and waits for them, for when the event loop can't go on
+	void abort_running();
+
+	int mMax_running;
+	SolverLimits mLimits;
+	int mEpoll = -1;
+	bool mPidfd_supported = true;
+
+	std::vector<SupervisedJob> mJobs;
+	std::vector<int> mRunning;
+};
@@ -3,6 +3,19 @@
 
 #include "pch.h"
 #include "Sudoku.h"
+#include "WorkStealingPool.h"
+#include "BoundedQueue.h"
+#include "SolverSupervisor.h"
+#include "ScratchFile.h"
+#include "SolverAdapter.h"
+#include "SolveServer.h"
+#include "AllocationCounter.h"
+#include "Checkpoint.h"
+#include "SudokuParser.h"
+#include "MappedFile.h"
+#include "Corpus.h"
+#include "SolutionValidator.h"
+#include "Trace.h"
 #include <fstream>
 #include <utility>
 #include <iostream>
@@ -13,15 +26,27 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <cstring>
 #include <sys/wait.h>
+#include <sys/resource.h>
+#include <cerrno>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <random>
+#include <iomanip>
+#include <map>
+#include <functional>
 
 const int MAX_PRINT_SIZE = 36;
-const int HEADER_LINES = 4;
 
-const bool COMMANDER_ENCODING = true; 				//toggles if the advanced "commander encoding" is used for the "at most one"-clauses
-const bool COMMANDER_ENCODING_BINARY = false;		//toggles if the binary tree commander encoding or the new one is used
 const int COMMANDER_ENCODING_SIZES[] = {0, 0, 0, 3, 4, 5, 4, 6, 4, 4, 3, 4, 6, 4, 4, 3};
-unsigned COMMANDER_ENCODING_MAX_SIZE = 5;			//defines the maximum group size for clauses when using the commander encoding
+const int COMMANDER_ENCODING_SIZES_COUNT = sizeof(COMMANDER_ENCODING_SIZES) / sizeof(COMMANDER_ENCODING_SIZES[0]);
+unsigned COMMANDER_ENCODING_MAX_SIZE = 5;			//defines the maximum group size for clauses when using the commander encoding, used for orders without a measured size
 const bool ENCODE_EXTRA_COMMANDERS = false;			//toggles if extra commanders will be generated for single variables
 
 const bool SIMPLE_SOLVING_ENABLED = true;			//toggles whether the encoder tries to use simple rules on the sudoku before encoding
@@ -31,19 +56,28 @@ const bool BOX_LINE_REDUCTION_ENABLED = true;		//toggles advanced rule "box line
 //disabled since it rarely actually finds anything new
 const bool X_WING_ENABLED = false;					//toggles advanced rule "x_wing" for the simple solve part
 
-pid_t command_pid = -1;
+//process groups of all running commands, so the signal handler can kill them, 0 marks a free slot
+const int MAX_RUNNING_COMMANDS = 256;
+std::atomic<pid_t> running_commands[MAX_RUNNING_COMMANDS];
+
+const int HANDLED_SIGNALS[] = {SIGABRT, SIGFPE, SIGILL, SIGINT, SIGSEGV, SIGTERM};
+
+//first value of a checkpoint file, "SUDCKPT" and the version of the layout
+const std::uint64_t CHECKPOINT_MAGIC = 0x0154504b43445553;
+const std::uint64_t MAX_CHECKPOINT_SIZE = 1024;		//largest size a checkpoint is trusted with, far above the instances
+
+const std::size_t CORPUS_CHUNK_SIZE = 4096;			//sudokus of a corpus read ahead and solved together
+const std::size_t CORPUS_TASK_SIZE = 64;			//sudokus of a chunk a thread takes at once
+
+const int SATISFIABLE_EXIT_CODE = 10;				//exit codes of the sat competition, used by clasp and most other solvers
+const int UNSATISFIABLE_EXIT_CODE = 20;
 
 int main(const int argc, char** argv)
 {
 	auto start = std::chrono::steady_clock::now();
 
 	//register signal handler for all possible signals
-	signal(SIGABRT, signal_handler);
-	signal(SIGFPE, signal_handler);
-	signal(SIGILL, signal_handler);
-	signal(SIGINT, signal_handler);
-	signal(SIGSEGV, signal_handler);
-	signal(SIGTERM, signal_handler);
+	for (auto signum : HANDLED_SIGNALS) signal(signum, signal_handler);
 
     //std::cout << "Sudoku Solver by Anton Reinhard!" << std::endl;
 
@@ -54,11 +88,18 @@ int main(const int argc, char** argv)
 	}
 
 	
-	//collect commandline options
+	//collect commandline options, short ones like -v and long ones like --ordering=box
 	std::vector<char> options;
+	std::vector<std::pair<std::string, std::string>> long_options;
 
 	for (auto i = 2; i < argc; ++i) {
-		if (argv[i][0] == '-') {
+		if (argv[i][0] == '-' && argv[i][1] == '-') {
+			std::string option = argv[i] + 2;
+			const auto equals = option.find('=');
+			if (equals == std::string::npos) long_options.push_back({option, ""});
+			else long_options.push_back({option.substr(0, equals), option.substr(equals + 1)});
+		}
+		else if (argv[i][0] == '-') {
 			options.push_back(argv[i][1]);
 		}
 	}
@@ -66,6 +107,14 @@ int main(const int argc, char** argv)
 	auto use_standard_size = false;
 	auto verbose = false;
 	auto omit_output = false;
+	EncodingOptions encoding_options;
+	ParallelOptions parallel_options;
+	std::string portfolio_variants = "commander,commander:3,commander:6,binary";
+	std::string socket_path;
+	auto check_consistency = true;
+	std::unique_ptr<SolutionCache> cache;
+	ReuseOptions reuse_options;
+	BenchOptions bench_options;
 
 	for (auto option : options) {
 		if (option == 'v') {
@@ -78,12 +127,73 @@ int main(const int argc, char** argv)
 		}
 	}
 
+	for (const auto& option : long_options) {
+		if (option.first == "ordering") {
+			if (!parse_atom_ordering(option.second, &encoding_options.ordering))
+				std::cout << "Unknown atom ordering \"" << option.second << "\", possible are cell, digit, box, curve." << std::endl;
+		} else if (option.first == "interleave") {
+			encoding_options.interleave_clauses = true;
+		} else if (option.first == "commanders-near-groups") {
+			encoding_options.commanders_near_groups = true;
+		} else if (option.first == "cubes") {
+			parallel_options.cubes = std::atoi(option.second.c_str());
+		} else if (option.first == "cube-speedup") {
+			parallel_options.cube_speedup = true;
+		} else if (option.first == "jobs") {
+			parallel_options.jobs = std::atoi(option.second.c_str());
+		} else if (option.first == "time-limit") {
+			parallel_options.limits.wall_seconds = std::atof(option.second.c_str());
+		} else if (option.first == "cpu-limit") {
+			parallel_options.limits.cpu_seconds = std::atoi(option.second.c_str());
+		} else if (option.first == "memory-scratch") {
+			parallel_options.memory_scratch = true;
+		} else if (option.first == "pipeline") {
+			parallel_options.pipeline = true;
+		} else if (option.first == "queue") {
+			parallel_options.queue_size = std::atoi(option.second.c_str());
+		} else if (option.first == "variants") {
+			portfolio_variants = option.second;
+		} else if (option.first == "cache") {
+			cache.reset(new SolutionCache(option.second));
+		} else if (option.first == "checkpoint") {
+			reuse_options.checkpoint_directory = option.second.empty() ? "checkpoints" : option.second;
+			if (mkdir(reuse_options.checkpoint_directory.c_str(), 0755) == -1 && errno != EEXIST)
+				std::cout << "Couldn't create the checkpoint folder \"" << reuse_options.checkpoint_directory << "\"." << std::endl;
+		} else if (option.first == "repeat") {
+			bench_options.repeats = std::atoi(option.second.c_str());
+		} else if (option.first == "warmup") {
+			bench_options.warmup = std::atoi(option.second.c_str());
+		} else if (option.first == "threshold") {
+			bench_options.threshold = std::atof(option.second.c_str());
+		} else if (option.first == "min-seconds") {
+			bench_options.min_seconds = std::atof(option.second.c_str());
+		} else if (option.first == "solver") {
+			bench_options.solver = option.second;
+		} else if (option.first == "no-consistency") {
+			check_consistency = false;
+		} else if (option.first == "counters") {
+			enable_counters();
+		} else if (option.first == "trace") {
+			enable_trace(option.second.empty() ? "trace.json" : option.second);
+		} else if (option.first == "socket") {
+			socket_path = option.second;
+		} else if (option.first == "amo") {
+			if (!parse_portfolio_variant(option.second, &encoding_options))
+				std::cout << "Unknown at most one encoding \"" << option.second << "\", possible are commander[:size], binary, naive." << std::endl;
+		}
+		else {
+			std::cout << "Encountered unknown option \"" << option.first << "\", ignoring." << std::endl;
+		}
+	}
+
+	reuse_options.cache = cache.get();
+
 	std::string command = argv[1];
 
 	if (command == "-h" || command == "help")
 	{
 		std::cout << "Usage: ./Sudoku [command] [arguments] [options]" << std::endl;
-		std::cout << "Possible commands are: solve, benchmark" << std::endl;
+		std::cout << "Possible commands are: solve, portfolio, benchmark, bench, compare, batch, corpus, pack, validate, serve, setup-bench, parse-bench, generate" << std::endl;
 	}
 	else if (command == "solve")
 	{
@@ -98,35 +208,237 @@ int main(const int argc, char** argv)
 		const std::string path = argv[path_index];
 		const std::string solver = argv[solver_index];
 
-		if (solver != "clasp")
+		if (!check_solver(solver)) return 0;
+
+		solve_sudoku(path, solver, "", verbose, omit_output, encoding_options, parallel_options, "", reuse_options);
+	}
+	else if (command == "portfolio")
+	{
+		if (argc <= 3)
 		{
-			std::cout << "Solvers other than clasp are not supported right now." << std::endl;
+			std::cout << "Usage: ./Sudoku portfolio [path] [sat-solver] [--variants=commander,commander:3,binary,naive] [options]" << std::endl;
 			return 0;
 		}
 
-		solve_sudoku(path, solver, "", verbose, omit_output);
+		const std::string path = argv[2];
+		const std::string solver = argv[3];
+
+		//every variant starts from the layout options given on the commandline
+		std::vector<EncodingOptions> variants;
+		std::stringstream variant_list(portfolio_variants);
+		std::string variant;
+		while (std::getline(variant_list, variant, ','))
+		{
+			auto options = encoding_options;
+			if (parse_portfolio_variant(variant, &options)) variants.push_back(options);
+			else std::cout << "Unknown portfolio variant \"" << variant << "\", possible are commander[:size], binary, naive." << std::endl;
+		}
+
+		if (variants.empty()) return -1;
+
+		if (!check_solver(solver)) return 0;
+
+		const auto jobs = parallel_options.jobs > 0 ? parallel_options.jobs : int(variants.size());
+		solve_portfolio(path, solver, variants, jobs, parallel_options, verbose, omit_output);
+	}
+	else if (command == "batch")
+	{
+		//everything after solver and output file that isn't an option is a folder or a sudoku
+		std::vector<std::string> paths;
+		for (auto i = 4; i < argc; ++i)
+			if (argv[i][0] != '-') paths.push_back(argv[i]);
+
+		if (paths.empty())
+		{
+			std::cout << "Too few arguments for batch! Usage: ./Sudoku batch [solver] [output file] [folders or files...] [options]" << std::endl;
+			return -1;
+		}
+
+		if (!check_solver(argv[2])) return 0;
+
+		batch_sudokus(paths, argv[2], argv[3], encoding_options, parallel_options, reuse_options);
 	}
 	else if (command == "benchmark")
 	{
 		if (argc <= 4) 
 		{
-			std::cout << "Too few arguments for benchmark! Usage: ./Sudoku benchmark [folder] [solver] [output file] [options]" << std::endl;
+			std::cout << "Too few arguments for benchmark! Usage: ./Sudoku benchmark [folder] [solver[,solver...]] [output file] [options]" << std::endl;
 			return -1;
 		}
 
 		std::string folder = argv[2];
-		std::string solver = argv[3];
 		std::string output_file = argv[4];
 
-		benchmark_sudokus(folder, solver, output_file);
+		//several solvers are compared on the same sudokus
+		std::vector<std::string> solvers;
+		std::stringstream solver_list(argv[3]);
+		std::string solver;
+		while (std::getline(solver_list, solver, ','))
+		{
+			if (!check_solver(solver)) return 0;
+			solvers.push_back(solver);
+		}
+
+		benchmark_sudokus(folder, solvers, output_file, encoding_options, parallel_options, reuse_options);
+	}
+	else if (command == "serve")
+	{
+		if (argc <= 2 || argv[2][0] == '-')
+		{
+			std::cout << "Usage: ./Sudoku serve [sat-solver] [--socket=path] [options]" << std::endl;
+			return 0;
+		}
+
+		if (!check_solver(argv[2])) return 0;
+
+		SolveServer server(argv[2], encoding_options, parallel_options, verbose, cache.get());
+		if (!socket_path.empty()) return server.serve_socket(socket_path) ? 0 : -1;
+
+		//one sudoku per line on stdin, stdout only gets the answers
+		server.serve_stream(STDIN_FILENO, STDOUT_FILENO, false);
+		return 0;
+	}
+	else if (command == "corpus")
+	{
+		//everything after solver and output file that isn't an option is a corpus, a folder or a sudoku
+		std::vector<std::string> paths;
+		for (auto i = 4; i < argc; ++i)
+			if (argv[i][0] != '-') paths.push_back(argv[i]);
+
+		if (paths.empty())
+		{
+			std::cout << "Too few arguments for corpus! Usage: ./Sudoku corpus [solver] [output file] [corpora, folders or files...] [options]" << std::endl;
+			return -1;
+		}
+
+		if (!check_solver(argv[2])) return 0;
+
+		solve_corpus(paths, argv[2], argv[3], encoding_options, parallel_options, reuse_options);
+	}
+	else if (command == "pack")
+	{
+		std::vector<std::string> paths;
+		for (auto i = 3; i < argc; ++i)
+			if (argv[i][0] != '-') paths.push_back(argv[i]);
+
+		if (paths.empty())
+		{
+			std::cout << "Too few arguments for pack! Usage: ./Sudoku pack [output corpus] [corpora, folders or files...]" << std::endl;
+			return -1;
+		}
+
+		if (!pack_corpus(paths, argv[2])) return -1;
+	}
+	else if (command == "validate")
+	{
+		if (argc <= 4 || argv[2][0] == '-' || argv[3][0] == '-' || argv[4][0] == '-')
+		{
+			std::cout << "Usage: ./Sudoku validate [sudoku folder or file] [output folder or file] [verdict csv] [--no-consistency] [--jobs=J]" << std::endl;
+			return -1;
+		}
+
+		const auto jobs = parallel_options.jobs > 0 ? parallel_options.jobs : int(std::max(1u, std::thread::hardware_concurrency()));
+		validate_sudokus(argv[2], argv[3], argv[4], jobs, check_consistency);
+	}
+	else if (command == "bench")
+	{
+		//everything after the output file that isn't an option is a folder or a sudoku
+		std::vector<std::string> paths;
+		for (auto i = 3; i < argc; ++i)
+			if (argv[i][0] != '-') paths.push_back(argv[i]);
+
+		if (paths.empty())
+		{
+			std::cout << "Too few arguments for bench! Usage: ./Sudoku bench [output csv] [folders or files...] [--repeat=N] [--warmup=W] [--solver=name] [options]" << std::endl;
+			return -1;
+		}
+
+		if (!bench_options.solver.empty() && !check_solver(bench_options.solver)) return 0;
+
+		bench_sudokus(paths, argv[2], bench_options, encoding_options, parallel_options);
+	}
+	else if (command == "compare")
+	{
+		std::vector<std::string> paths;
+		for (auto i = 4; i < argc; ++i)
+			if (argv[i][0] != '-') paths.push_back(argv[i]);
+
+		if (paths.empty())
+		{
+			std::cout << "Too few arguments for compare! Usage: ./Sudoku compare [baseline csv] [output csv] [folders or files...] [--threshold=0.1] [bench options]" << std::endl;
+			return -1;
+		}
+
+		//the seconds of the benchmark command include the solver, a total without it would look like a speedup
+		if (bench_options.solver.empty() && is_totals_only(argv[2]))
+		{
+			std::cout << "\"" << argv[2] << "\" is a csv of the benchmark command, its seconds include the solver. "
+					  << "Compare with --solver=name of the solver it was measured with." << std::endl;
+			return -1;
+		}
+
+		if (!bench_options.solver.empty() && !check_solver(bench_options.solver)) return 0;
+
+		bench_sudokus(paths, argv[3], bench_options, encoding_options, parallel_options);
+
+		//a regression fails the run, so scripts can stop before deploying it
+		if (!compare_to_baseline(argv[2], argv[3], bench_options.threshold, bench_options.min_seconds)) return 1;
+	}
+	else if (command == "setup-bench")
+	{
+		if (argc <= 2)
+		{
+			std::cout << "Usage: ./Sudoku setup-bench [path] [count]" << std::endl;
+			return 0;
+		}
+
+		const auto count = (argc > 3 && argv[3][0] != '-') ? std::atoi(argv[3]) : 10000;
+		benchmark_setup(argv[2], std::max(count, 1));
+	}
+	else if (command == "parse-bench")
+	{
+		//the files and an optional repeat count
+		std::vector<std::string> paths;
+		auto count = 100;
+		for (auto i = 2; i < argc; ++i)
+		{
+			if (argv[i][0] == '-') continue;
+			if (std::all_of(argv[i], argv[i] + std::strlen(argv[i]), ::isdigit)) count = std::atoi(argv[i]);
+			else paths.push_back(argv[i]);
+		}
+
+		if (paths.empty())
+		{
+			std::cout << "Usage: ./Sudoku parse-bench [files...] [count]" << std::endl;
+			return 0;
+		}
+
+		benchmark_parser(paths, std::max(count, 1));
+	}
+	else if (command == "generate")
+	{
+		if (argc <= 4)
+		{
+			std::cout << "Too few arguments for generate! Usage: ./Sudoku generate [n] [count] [folder] [given ratio] [options]" << std::endl;
+			return -1;
+		}
+
+		const auto n = std::atoi(argv[2]);
+		const auto count = std::atoi(argv[3]);
+		const std::string folder = argv[4];
+		const auto given_ratio = (argc > 5 && argv[5][0] != '-') ? std::atof(argv[5]) : 0.5;
+
+		generate_sudokus(n, count, folder, given_ratio);
 	}
 	else 
 	{
 		std::cout << "Unknown command \"" << command << "\"" << std::endl;
-		std::cout << "Possible commands are: solve, benchmark" << std::endl;
+		std::cout << "Possible commands are: solve, portfolio, benchmark, bench, compare, batch, corpus, pack, validate, serve, setup-bench, parse-bench, generate" << std::endl;
 		return 0;
 	}
 
+	if (cache) cache->print_statistics(std::cout);
+
 	auto end = std::chrono::steady_clock::now();
 
 	auto diff = end - start;
@@ -136,57 +448,1044 @@ int main(const int argc, char** argv)
 	return 0;
 }
 
-void benchmark_sudokus(std::string path, std::string solver, std::string output_path)
+void benchmark_sudokus(std::string path, const std::vector<std::string>& solvers, std::string output_path, const EncodingOptions& encoding_options,
+					   const ParallelOptions& parallel_options, const ReuseOptions& reuse)
+{
+	std::cout << "Benchmarking at " << path << " with solver";
+	for (const auto& solver : solvers) std::cout << " " << solver;
+	std::cout << "..." << std::endl;
+
+	write_benchmark_header(output_path);
+
+	//collect all the files named extable<size>-<count>.txt, there's no upper limit for the size
+	std::vector<std::pair<std::pair<int, int>, std::string>> files;
+
+	auto dir = opendir(path.c_str());
+	if (!dir)
+	{
+		std::cerr << "Couldn't open folder \"" << path << "\"." << std::endl;
+		return;
+	}
+
+	while (auto entry = readdir(dir))
+	{
+		int size, count;
+		char rest;
+		if (sscanf(entry->d_name, "extable%d-%d.tx%c", &size, &count, &rest) == 3 && rest == 't')
+		{
+			files.push_back({{size, count}, path + "/" + entry->d_name});
+		}
+	}
+
+	closedir(dir);
+
+	//solve in the order of size, then count
+	std::sort(files.begin(), files.end());
+
+	for (const auto& file : files)
+	{
+		std::cout << "Solving Sudoku at " << file.second << std::endl;
+
+		//the encoding is deterministic, so every solver gets exactly the same cnf
+		for (const auto& solver : solvers)
+			solve_sudoku(file.second, solver, output_path, false, true, encoding_options, parallel_options, "", reuse);
+	}
+
+	if (solvers.size() > 1)
+		print_solver_comparison(output_path);
+}
+
+//times every phase of every sudoku separately, repeated after a warmup, and writes median, min and p95 of each phase as csv
+//one row per sudoku and phase plus the total of all phases, the clauses per second are the clauses over the median
+void bench_sudokus(const std::vector<std::string>& paths, const std::string& output_path, const BenchOptions& bench_options,
+				   const EncodingOptions& encoding_options, const ParallelOptions& parallel_options)
+{
+	const auto files = collect_sudoku_files(paths);
+	const auto with_solver = !bench_options.solver.empty();
+	const auto adapter = with_solver ? SolverAdapter::get(bench_options.solver) : SolverAdapter();
+	const auto repeats = std::max(bench_options.repeats, 1);
+	const auto warmup = std::max(bench_options.warmup, 0);
+
+	std::cout << "Timing the phases of " << files.size() << " Sudokus, " << warmup << " warmup and " << repeats << " timed runs each"
+			  << (with_solver ? " with solver " + bench_options.solver : ", without solver") << std::endl;
+
+	std::ofstream csv(output_path);
+	csv << "Sudoku,Size,Phase,Repeats,Median Seconds,Min Seconds,P95 Seconds,Clauses,Clauses per Second,Cycles,Instructions,LLC Misses,Branch Misses\n";
+
+	std::vector<ScratchFile> scratch_files;
+	const auto in_memory = parallel_options.memory_scratch;
+	const auto prefix = get_process_prefix("bench");
+	const auto temp_filename = get_scratch_path(prefix + "temp_clauses.txt", in_memory, &scratch_files);
+	const auto cnf_filename = get_scratch_path(prefix + "clauses_out.cnf", in_memory, &scratch_files);
+	const auto model_filename = get_scratch_path(prefix + "model.txt", in_memory, &scratch_files);
+
+	for (const auto& file : files)
+	{
+		std::vector<std::vector<double>> samples(PHASE_COUNT);
+		std::vector<double> totals;
+		std::vector<std::vector<CounterValues>> counter_samples(PHASE_COUNT);
+		std::vector<CounterValues> counter_totals;
+		auto size = 0;
+		std::int64_t clauses = 0;
+		auto unanswered = 0;		//timed runs without a model, they are left out
+
+		for (auto run = 0; run < warmup + repeats; ++run)
+		{
+			double seconds[PHASE_COUNT] = {};
+			CounterValues counters[PHASE_COUNT];
+			std::unique_ptr<Sudoku> sudoku;
+			auto decoded = false;
+
+			//the counters are read around the clock, so their syscalls aren't timed
+			const auto timed = [&seconds, &counters](const Phase phase, const std::function<void()>& work) {
+				CounterValues counters_start, counters_end;
+				const auto counted = read_counters(&counters_start);
+				const auto start = std::chrono::steady_clock::now();
+				work();
+				seconds[int(phase)] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (counted && read_counters(&counters_end)) counters[int(phase)] = get_counter_difference(counters_start, counters_end);
+			};
+
+			timed(Phase::parse, [&]() { sudoku.reset(new Sudoku(file, false)); });
+			if (!sudoku->get_size() || !sudoku->is_solvable()) break;
+
+			if (SIMPLE_SOLVING_ENABLED) timed(Phase::preprocess, [&]() { sudoku->simple_solve(); });
+
+			//the encoder is timed even if the preprocessing already solved the sudoku
+			sudoku->set_scratch_files(temp_filename, cnf_filename);
+			sudoku->set_encoding_options(encoding_options);
+			timed(Phase::lut, [&]() { sudoku->create_lut(); });
+			timed(Phase::encode, [&]() { sudoku->generate_all_clauses(); });
+			timed(Phase::write, [&]() { sudoku->write_clauses(); });
+
+			if (with_solver)
+			{
+				auto solved_by = -1;
+				timed(Phase::solver, [&]() {
+					auto answer = 0;
+					struct rusage usage{};
+					double cpu_seconds;
+					solved_by = run_solvers_until_answer(adapter, {cnf_filename}, {model_filename}, 1, true, &answer, &usage, &cpu_seconds,
+														 parallel_options.limits);
+					if (answer != 1) solved_by = -1;
+				});
+				if (solved_by != -1) timed(Phase::decode, [&]() { sudoku->read_solution(model_filename, adapter.format); });
+				decoded = solved_by != -1;
+			}
+
+			std::string grid;
+			timed(Phase::render, [&]() { sudoku->render(&grid); });
+
+			size = sudoku->get_size();
+			clauses = sudoku->get_number_of_clauses();
+
+			if (run < warmup) continue;
+
+			//a run without decode would pull down its median and the total
+			if (with_solver && !decoded)
+			{
+				++unanswered;
+				continue;
+			}
+
+			auto total = 0.;
+			CounterValues counter_total;
+			for (auto phase = 0; phase < PHASE_COUNT; ++phase)
+			{
+				samples[phase].push_back(seconds[phase]);
+				total += seconds[phase];
+
+				counter_samples[phase].push_back(counters[phase]);
+				for (auto counter = 0; counter < HARDWARE_COUNTER_COUNT; ++counter)
+				{
+					if (counters[phase].values[counter] == -1) continue;
+					if (counter_total.values[counter] == -1) counter_total.values[counter] = 0;
+					counter_total.values[counter] += counters[phase].values[counter];
+				}
+			}
+			totals.push_back(total);
+			counter_totals.push_back(counter_total);
+		}
+
+		if (unanswered) std::cerr << "The solver didn't answer " << unanswered << " of the " << repeats << " runs of \"" << file << "\"." << std::endl;
+		if (totals.empty())
+		{
+			std::cerr << "Couldn't time the Sudoku at \"" << file << "\"." << std::endl;
+			continue;
+		}
+
+		std::cout << file << " (" << size << "x" << size << ", " << clauses << " clauses), median seconds:";
+
+		//the counters are the medians of the runs, empty if they weren't counted
+		const auto write_row = [&](const std::string& phase, const std::vector<double>& phase_samples,
+								   const std::vector<CounterValues>& phase_counters) {
+			const auto statistics = summarize_samples(phase_samples);
+			csv << file << "," << size << "," << phase << "," << phase_samples.size() << "," << statistics.median << "," << statistics.min
+				<< "," << statistics.p95 << "," << clauses << "," << (statistics.median > 0 ? clauses / statistics.median : 0.);
+
+			for (auto counter = 0; counter < HARDWARE_COUNTER_COUNT; ++counter)
+			{
+				std::vector<double> counts;
+				for (const auto& values : phase_counters)
+					if (values.values[counter] != -1) counts.push_back(double(values.values[counter]));
+
+				csv << ",";
+				if (!counts.empty()) csv << std::int64_t(summarize_samples(counts).median);
+			}
+			csv << "\n";
+			std::cout << " " << phase << " " << statistics.median;
+		};
+
+		for (auto phase = 0; phase < PHASE_COUNT; ++phase)
+		{
+			const auto skipped = !with_solver && (Phase(phase) == Phase::solver || Phase(phase) == Phase::decode);
+			if (!skipped) write_row(get_phase_name(Phase(phase)), samples[phase], counter_samples[phase]);
+		}
+		write_row("total", totals, counter_totals);
+		std::cout << std::endl;
+	}
+
+	if (!in_memory)
+	{
+		std::remove(temp_filename.c_str());
+		std::remove(cnf_filename.c_str());
+		std::remove(model_filename.c_str());
+	}
+}
+
+//measures what it costs to get a sudoku ready for encoding, from the file, in a new object and in a reused one
+void benchmark_setup(const std::string& path, const int count)
+{
+	std::vector<int> cells;
+	int size;
+	{
+		Sudoku original(path, false);
+		if (!parse_sudoku_line(original.get_line(), &cells, &size))
+		{
+			std::cerr << "Couldn't read the Sudoku at \"" << path << "\"." << std::endl;
+			return;
+		}
+	}
+
+	std::cout << "Setup of a " << size << "x" << size << " Sudoku, " << count << " times:" << std::endl;
+	allocation_counting = true;
+
+	const auto measure = [&](const std::string& name, const std::function<void()>& setup) {
+		const auto allocations = get_allocation_count();
+		const auto start = std::chrono::steady_clock::now();
+
+		for (auto i = 0; i < count; ++i) setup();
+
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::left << std::setw(44) << name << std::right << std::setw(10) << seconds / count * 1e6 << " us, "
+				  << std::setw(8) << double(get_allocation_count() - allocations) / count << " allocations per Sudoku" << std::endl;
+	};
+
+	measure("read from the file", [&]() { Sudoku sudoku(path, false); });
+	measure("new Sudoku + load()", [&]() { Sudoku sudoku(size, false); sudoku.load(cells); });
+
+	Sudoku reused(size, false);
+	reused.load(cells);
+	reused.simple_solve();
+	reused.create_lut();
+
+	measure("reused load()", [&]() { reused.load(cells); });
+	measure("reused load() + preprocessing + create_lut()", [&]() {
+		reused.load(cells);
+		reused.simple_solve();
+		reused.create_lut();
+	});
+}
+
+//measures the throughput of the file parser in MB/s, on the mapped text alone, with the mapping and into a new sudoku
+void benchmark_parser(const std::vector<std::string>& paths, const int count)
+{
+	std::cout << "Parsing every file " << count << " times:" << std::endl;
+
+	for (const auto& path : paths)
+	{
+		const MappedFile file(path);
+		std::vector<int> cells;
+		int size;
+		if (!file.is_open() || !parse_sudoku_text(file.data(), file.data() + file.size(), &cells, &size))
+		{
+			std::cerr << "Couldn't read the Sudoku at \"" << path << "\"." << std::endl;
+			continue;
+		}
+
+		const auto megabytes = double(file.size()) / (1 << 20);
+		std::cout << path << " (" << size << "x" << size << ", " << file.size() << " bytes)" << std::endl;
+
+		const auto measure = [&](const std::string& name, const std::function<void()>& parse) {
+			const auto start = std::chrono::steady_clock::now();
+
+			for (auto i = 0; i < count; ++i) parse();
+
+			const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << "  " << std::left << std::setw(34) << name << std::right << std::setw(10) << seconds / count * 1e6 << " us, "
+					  << std::setw(8) << megabytes * count / seconds << " MB/s" << std::endl;
+		};
+
+		measure("scan of the mapped text", [&]() { parse_sudoku_text(file.data(), file.data() + file.size(), &cells, &size); });
+		measure("mmap + scan", [&]() { read_sudoku_file(path, &cells, &size); });
+		measure("new Sudoku (scan + set_field)", [&]() { Sudoku sudoku(path, false); });
+	}
+}
+
+//reads a benchmark csv and prints the average solver time of every solver for every size
+void print_solver_comparison(const std::string& benchmark_path)
+{
+	//size -> solver -> summed seconds and count
+	std::map<int, std::map<std::string, std::pair<double, int>>> times;
+
+	std::ifstream benchmark(benchmark_path);
+	std::string line;
+	std::getline(benchmark, line);
+
+	//the columns are found by name, the csv keeps growing at the end
+	const auto header = split_csv_line(line);
+	const auto find_column = [&header](const std::string& name) {
+		return std::size_t(std::find(header.begin(), header.end(), name) - header.begin());
+	};
+	const auto size_column = find_column("Size");
+	const auto seconds_column = find_column("Solver Seconds");
+	const auto solver_column = find_column("Solver");
+	if (size_column == header.size() || seconds_column == header.size() || solver_column == header.size()) return;
+	const auto needed = std::max(size_column, std::max(seconds_column, solver_column)) + 1;
+
+	while (std::getline(benchmark, line))
+	{
+		const auto columns = split_csv_line(line);
+		if (columns.size() < needed) continue;
+
+		auto& entry = times[std::atoi(columns[size_column].c_str())][columns[solver_column]];
+		entry.first += std::atof(columns[seconds_column].c_str());
+		++entry.second;
+	}
+
+	std::cout << "Average solver seconds per size:" << std::endl;
+	for (const auto& size : times)
+	{
+		std::cout << std::setw(5) << size.first << ":";
+
+		std::string fastest;
+		auto fastest_seconds = 0.;
+		for (const auto& solver : size.second)
+		{
+			const auto seconds = solver.second.first / solver.second.second;
+			std::cout << " " << solver.first << " " << seconds;
+			if (fastest.empty() || seconds < fastest_seconds)
+			{
+				fastest = solver.first;
+				fastest_seconds = seconds;
+			}
+		}
+		std::cout << ", fastest " << fastest << std::endl;
+	}
+}
+
+//any folder or file given, folders contribute all their .txt files
+std::vector<std::string> collect_sudoku_files(const std::vector<std::string>& paths)
+{
+	std::vector<std::string> files;
+	for (const auto& path : paths)
+	{
+		auto dir = opendir(path.c_str());
+		if (!dir)
+		{
+			files.push_back(path);
+			continue;
+		}
+
+		std::vector<std::string> folder_files;
+		while (auto entry = readdir(dir))
+		{
+			const std::string name = entry->d_name;
+			if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0)
+				folder_files.push_back(path + "/" + name);
+		}
+		closedir(dir);
+
+		std::sort(folder_files.begin(), folder_files.end());
+		files.insert(files.end(), folder_files.begin(), folder_files.end());
+	}
+
+	return files;
+}
+
+void batch_sudokus(const std::vector<std::string>& paths, const std::string& solver, const std::string& output_path,
+				   const EncodingOptions& encoding_options, const ParallelOptions& parallel_options, const ReuseOptions& reuse)
+{
+	const auto files = collect_sudoku_files(paths);
+	const auto jobs = parallel_options.jobs > 0 ? parallel_options.jobs : std::max(1u, std::thread::hardware_concurrency());
+
+	std::cout << "Solving " << files.size() << " Sudokus with solver " << solver << " on " << jobs << " threads..." << std::endl;
+
+	write_benchmark_header(output_path);
+
+	if (parallel_options.pipeline)
+	{
+		pipeline_sudokus(files, solver, output_path, encoding_options, jobs, parallel_options, reuse);
+		return;
+	}
+
+	WorkStealingPool pool(jobs);
+	for (unsigned i = 0; i < files.size(); ++i)
+	{
+		const auto file = files[i];
+		const auto scratch_prefix = get_job_prefix(i);
+		pool.add([=, &solver, &output_path, &encoding_options, &reuse]() {
+			solve_sudoku(file, solver, output_path, false, true, encoding_options, parallel_options, scratch_prefix, reuse);
+
+			std::remove((scratch_prefix + "clauses_out.cnf").c_str());
+			std::remove((scratch_prefix + "model.txt").c_str());
+		});
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	pool.run();
+	const auto seconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() / 1000.;
+
+	auto steals = 0;
+	for (auto worker_steals : pool.get_steals()) steals += worker_steals;
+
+	std::cout << "Solved " << files.size() << " Sudokus in " << seconds << " seconds, "
+			  << (seconds > 0 ? files.size() / seconds : 0.) << " Sudokus per second, " << steals << " jobs stolen" << std::endl;
+}
+
+//a sudoku on its way through the pipeline
+struct PipelineJob
 {
-	std::cout << "Benchmarking at " << path << " with solver " << solver << "..." << std::endl;
+	std::string path;
+	std::string scratch_prefix;
+	std::vector<ScratchFile> scratch_files;
+	std::unique_ptr<Sudoku> sudoku;
+	std::chrono::steady_clock::duration busy{0};		//time the stages spent on this sudoku, without the queues
+	CanonicalSudoku canonical;							//only computed with a cache
+	bool resumed = false;								//read from a checkpoint, already preprocessed
+};
+
+void pipeline_sudokus(const std::vector<std::string>& files, const std::string& solver, const std::string& output_path,
+					  const EncodingOptions& encoding_options, const int jobs, const ParallelOptions& parallel_options, const ReuseOptions& reuse)
+{
+	const auto cache = reuse.cache;
+	const auto queue_size = parallel_options.queue_size;
+	const auto& limits = parallel_options.limits;
+	const auto adapter = SolverAdapter::get(solver);
+
+	//parse -> preprocess -> encode -> solve, the solve stage runs jobs solvers, the others one thread each
+	//while the solvers work the encoder already prepares the next sudokus, the queues limit how far it gets ahead
+	BoundedQueue<PipelineJob> parsed(queue_size);
+	BoundedQueue<PipelineJob> preprocessed(queue_size);
+	BoundedQueue<PipelineJob> encoded(queue_size);
+
+	const char* stage_names[] = {"parse", "preprocess", "encode", "solve"};
+	std::vector<std::chrono::steady_clock::duration> stage_busy(4 + jobs - 1, std::chrono::steady_clock::duration(0));
+
+	//runs work on the job and accounts the time to the job and the stage
+	const auto timed = [&stage_busy](const int stage, PipelineJob* job, const std::function<void()>& work) {
+		const auto start = std::chrono::steady_clock::now();
+		work();
+		const auto time = std::chrono::steady_clock::now() - start;
+		job->busy += time;
+		stage_busy[stage] += time;
+	};
+
+	const auto start = std::chrono::steady_clock::now();
+
+	//sudokus that ended up with every cell filled, from the cache or by a solver
+	std::atomic<int> solved(0);
+
+	std::vector<std::thread> threads;
+	threads.emplace_back([&]() {
+		for (unsigned i = 0; i < files.size(); ++i)
+		{
+			PipelineJob job;
+			job.path = files[i];
+			job.scratch_prefix = get_job_prefix(i);
+			timed(0, &job, [&]() {
+				if (!reuse.checkpoint_directory.empty())
+					job.sudoku = Sudoku::resume(job.path, get_checkpoint_path(reuse.checkpoint_directory, job.path), false);
+				job.resumed = job.sudoku != nullptr;
+				if (!job.resumed) job.sudoku.reset(new Sudoku(job.path, false));
+			});
+
+			if (!job.sudoku->is_solvable())
+			{
+				std::cerr << "Sudoku at " << job.path << " is unsolvable!" << std::endl;
+				continue;
+			}
+
+			//a known symmetry class skips the rest of the pipeline
+			auto hit = false;
+			if (cache)
+			{
+				timed(0, &job, [&]() {
+					std::vector<int> cells, solution;
+					job.sudoku->get_cells(&cells);
+					hit = cache->lookup(cells, job.sudoku->get_size(), &job.canonical, &solution) && job.sudoku->load(solution);
+				});
+			}
+
+			//a hit gets no benchmark row, it has no encoding or solver to measure
+			if (hit)
+			{
+				++solved;
+				continue;
+			}
+
+			parsed.push(std::move(job));
+		}
+		parsed.close();
+	});
+
+	threads.emplace_back([&]() {
+		PipelineJob job;
+		while (parsed.pop(&job))
+		{
+			if (SIMPLE_SOLVING_ENABLED && !job.resumed)
+				timed(1, &job, [&]() { job.sudoku->simple_solve(); });
+
+			//a contradiction found by the preprocessing needs neither encoder nor solver
+			if (!job.sudoku->is_solvable())
+			{
+				std::cerr << "Sudoku at " << job.path << " is unsolvable!" << std::endl;
+				continue;
+			}
+
+			preprocessed.push(std::move(job));
+		}
+		preprocessed.close();
+	});
 
-	auto n = 3;
-	auto count = 0;
+	threads.emplace_back([&]() {
+		PipelineJob job;
+		while (preprocessed.pop(&job))
+		{
+			timed(2, &job, [&]() {
+				job.sudoku->set_scratch_files(get_scratch_path(job.scratch_prefix + "temp_clauses.txt", parallel_options.memory_scratch, &job.scratch_files),
+											  get_scratch_path(job.scratch_prefix + "clauses_out.cnf", parallel_options.memory_scratch, &job.scratch_files));
+				job.sudoku->set_encoding_options(encoding_options);
+				job.sudoku->create_lut();
+				if (!reuse.checkpoint_directory.empty() && !job.resumed)
+					job.sudoku->write_checkpoint(get_checkpoint_path(reuse.checkpoint_directory, job.path));
+				job.sudoku->generate_all_clauses();
+				job.sudoku->write_clauses();
+			});
+			encoded.push(std::move(job));
+		}
+		encoded.close();
+	});
+
+	for (auto solver_thread = 0; solver_thread < jobs; ++solver_thread)
+	{
+		threads.emplace_back([&, solver_thread]() {
+			PipelineJob job;
+			while (encoded.pop(&job))
+			{
+				const auto model_filename = get_scratch_path(job.scratch_prefix + "model.txt", parallel_options.memory_scratch, &job.scratch_files);
+				struct rusage solver_usage{};
+				auto solver_time = std::chrono::steady_clock::duration(0);
+
+				timed(3 + solver_thread, &job, [&]() {
+					const auto solver_start = std::chrono::steady_clock::now();
+					int answer;
+					double cpu_seconds;
+					const auto solved = run_solvers_until_answer(adapter, {job.sudoku->get_clauses_filename()}, {model_filename}, 1, true,
+																 &answer, &solver_usage, &cpu_seconds, limits);
+					solver_time = std::chrono::steady_clock::now() - solver_start;
+
+					if (solved != -1 && answer == 1) job.sudoku->read_solution(model_filename, adapter.format);
+				});
+
+				const auto is_solved = job.sudoku->get_solved_fields() == job.sudoku->get_size() * job.sudoku->get_size();
+				if (is_solved) ++solved;
+
+				if (cache && is_solved)
+				{
+					std::vector<int> solution;
+					job.sudoku->get_cells(&solution);
+					cache->add(job.canonical, solution);
+				}
+
+				if (!parallel_options.memory_scratch)
+				{
+					std::remove(job.sudoku->get_clauses_filename().c_str());
+					std::remove(model_filename.c_str());
+				}
+				job.scratch_files.clear();
+
+				BenchmarkRow row;
+				row.path = job.path;
+				row.seconds = std::chrono::duration_cast<std::chrono::milliseconds>(job.busy).count() / 1000.;
+				row.solver_seconds = std::chrono::duration_cast<std::chrono::milliseconds>(solver_time).count() / 1000.;
+				row.solver_max_rss = solver_usage.ru_maxrss;
+				row.solver_cpu_seconds = get_cpu_seconds(solver_usage);
+				row.solver = solver;
+				append_benchmark_row(output_path, job.sudoku.get(), row, encoding_options);
+			}
+		});
+	}
 
-	std::ofstream benchmark(output_path);
+	for (auto& thread : threads) thread.join();
 
-	benchmark << "Sudoku,Size,CE-Size,No. Atoms,No. Clauses,Seconds\n";
+	const auto seconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() / 1000.;
 
-	benchmark.close();
+	//the solver threads are reported as one stage
+	for (auto solver_thread = 1; solver_thread < jobs; ++solver_thread) stage_busy[3] += stage_busy[3 + solver_thread];
 
-	do 
+	const BoundedQueue<PipelineJob>* queues[] = {&parsed, &preprocessed, &encoded};
+	for (auto stage = 0; stage < 4; ++stage)
 	{
-		std::stringstream full_path_ss;
-		std::string full_path;
-		std::ifstream file;
-		++count;
+		std::cout << std::setw(10) << stage_names[stage] << ": busy " << std::chrono::duration<double>(stage_busy[stage]).count() << " s";
+		if (stage > 0) std::cout << ", waiting for input " << queues[stage - 1]->get_pop_wait_seconds() << " s";
+		if (stage < 3) std::cout << ", blocked on output " << queues[stage]->get_push_wait_seconds() << " s"
+								 << ", output queue " << queues[stage]->get_average_occupancy() << "/" << queues[stage]->get_capacity();
+		std::cout << std::endl;
+	}
+
+	std::cout << "Solved " << solved << " of " << files.size() << " Sudokus in " << seconds << " seconds, "
+			  << (seconds > 0 ? solved / seconds : 0.) << " Sudokus per second" << std::endl;
+}
+
+//sudokus of a corpus that are solved together, the cells of all of them in one buffer
+struct CorpusChunk
+{
+	std::vector<int> cells;
+	std::vector<std::size_t> offsets;		//of every sudoku in cells
+	std::vector<int> sizes;
+	std::vector<RecordStatus> statuses;
+};
+
+void solve_corpus(const std::vector<std::string>& paths, const std::string& solver, const std::string& output_path,
+				  const EncodingOptions& encoding_options, const ParallelOptions& parallel_options, const ReuseOptions& reuse)
+{
+	const auto files = collect_sudoku_files(paths);
+	const auto jobs = parallel_options.jobs > 0 ? parallel_options.jobs : std::max(1u, std::thread::hardware_concurrency());
+
+	std::cout << "Solving the Sudokus of " << files.size() << " files with solver " << solver << " on " << jobs << " threads..." << std::endl;
+
+	//the sudokus of the corpus go through the pooled sudokus of the server, nothing is opened per sudoku
+	SolveServer server(solver, encoding_options, parallel_options, false, reuse.cache);
+	CorpusWriter writer(output_path, CorpusWriter::get_format(output_path));
+
+	//one thread reads chunks through the mapping while the previous chunk is solved
+	BoundedQueue<CorpusChunk> chunks(parallel_options.queue_size);
+	std::uint64_t bytes = 0;
 
-		full_path_ss << path << "/extable" << (n*n) << "-" << count << ".txt";
-		full_path_ss >> full_path;
+	const auto start = std::chrono::steady_clock::now();
 
-		file.open(full_path);
+	std::thread reader([&]() {
+		CorpusChunk chunk;
+		std::vector<int> cells;
+		int size;
+		RecordStatus status;
 
-		if (!file.is_open())	//if we couldn't open the file
+		for (const auto& file : files)
 		{
-			++n;
-			count = 0;
-		} else {
-			std::cout << "Solving Sudoku at " << full_path << std::endl;
+			CorpusReader corpus(file);
+			if (!corpus.is_open())
+			{
+				std::cerr << "Couldn't read the corpus at \"" << file << "\"." << std::endl;
+				continue;
+			}
+			bytes += corpus.get_bytes();
 
-			solve_sudoku(full_path, solver, output_path, false, true);
+			while (corpus.next(&cells, &size, &status))
+			{
+				chunk.offsets.push_back(chunk.cells.size());
+				chunk.cells.insert(chunk.cells.end(), cells.begin(), cells.end());
+				chunk.sizes.push_back(size);
+				chunk.statuses.push_back(status);
 
-			//std::cout << "Done solving Sudoku at " << full_path << std::endl;
+				if (chunk.sizes.size() == CORPUS_CHUNK_SIZE)
+				{
+					chunks.push(std::move(chunk));
+					chunk = CorpusChunk();
+				}
+			}
+		}
+
+		if (!chunk.sizes.empty()) chunks.push(std::move(chunk));
+		chunks.close();
+	});
+
+	std::uint64_t counts[int(RecordStatus::invalid) + 1] = {};
+	CorpusChunk chunk;
+	while (chunks.pop(&chunk))
+	{
+		//the solutions replace the sudokus in the buffer
+		WorkStealingPool pool(jobs);
+		for (std::size_t first = 0; first < chunk.sizes.size(); first += CORPUS_TASK_SIZE)
+		{
+			pool.add([&chunk, &server, first]() {
+				std::vector<int> cells, solution;
+				const auto last = std::min(first + CORPUS_TASK_SIZE, chunk.sizes.size());
+				for (auto i = first; i < last; ++i)
+				{
+					const auto size = chunk.sizes[i];
+					if (chunk.statuses[i] == RecordStatus::invalid) continue;
+
+					const auto sudoku = chunk.cells.begin() + chunk.offsets[i];
+					cells.assign(sudoku, sudoku + std::size_t(size) * size);
+
+					double solver_seconds;
+					const auto result = server.solve(cells, size, &solution, &solver_seconds);
+					if (result == SolveStatus::solved)
+					{
+						std::copy(solution.begin(), solution.end(), sudoku);
+						chunk.statuses[i] = RecordStatus::solved;
+					}
+					else chunk.statuses[i] = result == SolveStatus::unsolvable ? RecordStatus::unsolvable : RecordStatus::unknown;
+				}
+			});
 		}
-	} while (n <= 15);
+		pool.run();
+
+		for (std::size_t i = 0; i < chunk.sizes.size(); ++i)
+		{
+			writer.write(chunk.cells.data() + chunk.offsets[i], chunk.sizes[i], chunk.statuses[i]);
+			++counts[int(chunk.statuses[i])];
+		}
+	}
+	reader.join();
+
+	if (!writer.finish()) std::cerr << "Couldn't write the solutions to \"" << output_path << "\"." << std::endl;
+
+	const auto seconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() / 1000.;
+	std::uint64_t total = 0;
+	for (auto count : counts) total += count;
+
+	std::cout << "Solved " << counts[int(RecordStatus::solved)] << " of " << total << " Sudokus in " << seconds << " seconds, "
+			  << (seconds > 0 ? total / seconds : 0.) << " Sudokus per second, " << (seconds > 0 ? bytes / seconds / (1 << 20) : 0.) << " MB/s" << std::endl;
+	std::cout << counts[int(RecordStatus::unsolvable)] << " unsolvable, " << counts[int(RecordStatus::unknown)] << " unknown, "
+			  << counts[int(RecordStatus::invalid)] << " invalid" << std::endl;
 }
 
-void solve_sudoku(std::string path, std::string solver, std::string outputfile, bool verbose, bool omit_output)
+//copies the sudokus of any corpora or sudoku files into one corpus, e.g. to pack a text corpus into the binary format
+bool pack_corpus(const std::vector<std::string>& paths, const std::string& output_path)
 {
+	const auto files = collect_sudoku_files(paths);
+	CorpusWriter writer(output_path, CorpusWriter::get_format(output_path));
+
+	std::vector<int> cells;
+	int size;
+	RecordStatus status;
+	std::uint64_t records = 0;
+
+	for (const auto& file : files)
+	{
+		CorpusReader corpus(file);
+		if (!corpus.is_open())
+		{
+			std::cerr << "Couldn't read the corpus at \"" << file << "\"." << std::endl;
+			continue;
+		}
+
+		for (; corpus.next(&cells, &size, &status); ++records)
+			writer.write(cells.data(), size, status);
+	}
+
+	if (!writer.finish())
+	{
+		std::cerr << "Couldn't write the corpus to \"" << output_path << "\"." << std::endl;
+		return false;
+	}
+
+	std::cout << "Packed " << records << " Sudokus of " << files.size() << " files into " << output_path << std::endl;
+	return true;
+}
+
+//checks the printed solutions of runs against their sudokus like sudoku/validate.py and writes the verdicts as csv
+//the output of a sudoku is the file of the same name in the output folder, or the output file itself for a single sudoku
+void validate_sudokus(const std::string& task_path, const std::string& output_path, const std::string& verdict_path, const int jobs,
+					  const bool check_consistency)
+{
+	const auto tasks = collect_sudoku_files({task_path});
+
+	struct stat output_status{};
+	const auto output_folder = stat(output_path.c_str(), &output_status) == 0 && S_ISDIR(output_status.st_mode);
+
+	std::vector<std::string> outputs;
+	for (const auto& task : tasks)
+	{
+		const auto slash = task.rfind('/');
+		outputs.push_back(output_folder ? output_path + "/" + (slash == std::string::npos ? task : task.substr(slash + 1)) : output_path);
+	}
+
+	std::vector<char> verdicts(tasks.size(), false);
+	const auto start = std::chrono::steady_clock::now();
+
+	WorkStealingPool pool(jobs);
+	for (std::size_t i = 0; i < tasks.size(); ++i)
+	{
+		pool.add([&, i]() {
+			std::vector<int> givens, cells;
+			int task_size, output_size;
+			if (!read_sudoku_file(tasks[i], &givens, &task_size)) return;
+
+			const MappedFile output(outputs[i]);
+			if (!output.is_open() || !parse_sudoku_output(output.data(), output.data() + output.size(), &cells, &output_size) ||
+				output_size != task_size)
+				return;
+
+			//every worker keeps the validator of the size it checked last, the tasks of a run mostly share one size
+			static thread_local std::unique_ptr<SolutionValidator> validator;
+			if (!validator || validator->get_size() != task_size) validator.reset(new SolutionValidator(task_size));
+			verdicts[i] = validator->check(cells.data(), check_consistency ? givens.data() : nullptr);
+		});
+	}
+	pool.run();
+
+	const auto seconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() / 1000.;
+
+	//the columns of the verdict table, the run is named by its output
+	std::ofstream verdict_file(verdict_path);
+	verdict_file << "run,task,is_valid\n";
+
+	auto valid = 0;
+	for (std::size_t i = 0; i < tasks.size(); ++i)
+	{
+		verdict_file << outputs[i] << "," << tasks[i] << "," << (verdicts[i] ? "True" : "False") << "\n";
+		valid += verdicts[i];
+	}
+
+	std::cout << "Validated " << tasks.size() << " outputs in " << seconds << " seconds, " << valid << " valid, "
+			  << tasks.size() - valid << " invalid" << std::endl;
+}
+
+void solve_portfolio(const std::string& path, const std::string& solver, const std::vector<EncodingOptions>& variants,
+					 const int jobs, const ParallelOptions& parallel_options, const bool verbose, const bool omit_output)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	if (verbose) std::cout << "Solving Sudoku at \"" << path << "\" with a portfolio of " << variants.size() << " encodings" << std::endl;
+
+	//the preprocessing doesn't depend on the encoding, it's done once and copied into the sudoku of every variant
+	Sudoku preprocessed(path, verbose);
+	if (!preprocessed.get_size()) return;			//the file couldn't be read, that was already reported
+
+	if (SIMPLE_SOLVING_ENABLED && preprocessed.is_solvable())
+		preprocessed.simple_solve();
+
+	if (!preprocessed.is_solvable())
+	{
+		std::cerr << "This Sudoku is unsolvable!" << std::endl;
+		return;
+	}
+
+	std::vector<std::unique_ptr<Sudoku>> sudokus;
+	const auto adapter = SolverAdapter::get(solver);
+	std::vector<std::string> cnf_filenames;
+	std::vector<std::string> solution_filenames;
+	std::vector<ScratchFile> scratch_files;
+
+	for (unsigned i = 0; i < variants.size(); ++i)
+	{
+		//the variants are encoded at the same time, their progress output would only get mixed up
+		sudokus.push_back(std::unique_ptr<Sudoku>(new Sudoku(preprocessed.get_size(), false)));
+		auto& sudoku = *sudokus.back();
+		sudoku.copy_preprocessed(preprocessed);
+
+		const auto prefix = get_process_prefix("portfolio") + std::to_string(i) + "_";
+		sudoku.set_scratch_files(get_scratch_path(prefix + "temp_clauses.txt", parallel_options.memory_scratch, &scratch_files),
+								 get_scratch_path(prefix + "clauses_out.cnf", parallel_options.memory_scratch, &scratch_files));
+		sudoku.set_encoding_options(variants[i]);
+
+		solution_filenames.push_back(get_scratch_path(prefix + "model.txt", parallel_options.memory_scratch, &scratch_files));
+		cnf_filenames.push_back(sudoku.get_clauses_filename());
+	}
+
+	std::vector<std::thread> encoders;
+	for (auto& sudoku : sudokus)
+	{
+		encoders.emplace_back([&sudoku]() {
+			sudoku->create_lut();
+			sudoku->generate_all_clauses();
+			sudoku->write_clauses();
+		});
+	}
+	for (auto& encoder : encoders) encoder.join();
+
+	for (unsigned i = 0; i < variants.size() && verbose; ++i)
+		std::cout << "Variant " << i << " (" << get_encoding_name(variants[i]) << "): " << sudokus[i]->get_number_of_clauses() << " clauses" << std::endl;
+
+	auto time_encoding = std::chrono::steady_clock::now() - start;
+
+	//the first variant that answers decides, an unsatisfiable answer is as final as a model
+	int answer;
+	struct rusage solver_usage{};
+	auto solver_cpu_seconds = 0.;
+	const auto winner = run_solvers_until_answer(adapter, cnf_filenames, solution_filenames, jobs, true, &answer, &solver_usage, &solver_cpu_seconds,
+												 parallel_options.limits, verbose);
+
+	auto time_solver = std::chrono::steady_clock::now() - start - time_encoding;
+
+	if (winner == -1)
+		std::cerr << "No variant of the portfolio answered!" << std::endl;
+	else if (answer == 0)
+		std::cerr << "Variant " << winner << " (" << get_encoding_name(variants[winner]) << ") proved this Sudoku unsolvable!" << std::endl;
+	else
+	{
+		std::cout << "Variant " << winner << " (" << get_encoding_name(variants[winner]) << ") answered first" << std::endl;
+
+		sudokus[winner]->read_solution(solution_filenames[winner], adapter.format);
+		if (!omit_output)
+			sudokus[winner]->print();
+	}
+
+	for (unsigned i = 0; i < variants.size() && !parallel_options.memory_scratch; ++i)
+	{
+		std::remove(sudokus[i]->get_clauses_filename().c_str());
+		std::remove(solution_filenames[i].c_str());
+	}
+
+	std::cout << "Encoding took " << std::chrono::duration_cast<std::chrono::milliseconds>(time_encoding).count() / 1000. << " seconds" << std::endl;
+	std::cout << "Solving took " << std::chrono::duration_cast<std::chrono::milliseconds>(time_solver).count() / 1000.
+			  << " seconds, " << solver_cpu_seconds << " seconds of solver time" << std::endl;
+}
+
+//parses a portfolio variant like commander, commander:3, binary or naive, the rest of the options stays as given
+bool parse_portfolio_variant(const std::string& variant, EncodingOptions* options)
+{
+	const auto colon = variant.find(':');
+	const auto encoding = variant.substr(0, colon);
+
+	if (encoding == "commander") options->at_most_one = AtMostOneEncoding::commander;
+	else if (encoding == "binary") options->at_most_one = AtMostOneEncoding::binary_commander;
+	else if (encoding == "naive") options->at_most_one = AtMostOneEncoding::naive;
+	else return false;
+
+	options->commander_size = colon == std::string::npos ? 0 : std::atoi(variant.c_str() + colon + 1);
+	return true;
+}
+
+std::string get_encoding_name(const EncodingOptions& options)
+{
+	switch (options.at_most_one)
+	{
+	case AtMostOneEncoding::binary_commander: return "binary";
+	case AtMostOneEncoding::naive: return "naive";
+	default: return options.commander_size > 1 ? "commander:" + std::to_string(options.commander_size) : "commander";
+	}
+}
+
+void generate_sudokus(const int n, const int count, const std::string& folder, const double given_ratio)
+{
+	const auto size = n * n;
+	std::mt19937 random(std::random_device{}());
+
+	for (auto k = 1; k <= count; ++k)
+	{
+		std::stringstream path_ss;
+		path_ss << folder << "/extable" << size << "-" << k << ".txt";
+
+		std::cout << "Generating " << path_ss.str() << "..." << std::endl;
+
+		//shuffled versions of the pattern solution (n * (row % n) + row / n + column) % size
+		std::vector<int> digits(size), rows, columns;
+		for (auto i = 0; i < size; ++i) digits[i] = i + 1;
+		std::shuffle(digits.begin(), digits.end(), random);
+
+		std::vector<int> bands(n), stacks(n);
+		for (auto i = 0; i < n; ++i) bands[i] = stacks[i] = i;
+		std::shuffle(bands.begin(), bands.end(), random);
+		std::shuffle(stacks.begin(), stacks.end(), random);
+
+		for (auto band : bands)
+		{
+			std::vector<int> lines(n);
+			for (auto i = 0; i < n; ++i) lines[i] = band * n + i;
+			std::shuffle(lines.begin(), lines.end(), random);
+			rows.insert(rows.end(), lines.begin(), lines.end());
+		}
+		for (auto stack : stacks)
+		{
+			std::vector<int> lines(n);
+			for (auto i = 0; i < n; ++i) lines[i] = stack * n + i;
+			std::shuffle(lines.begin(), lines.end(), random);
+			columns.insert(columns.end(), lines.begin(), lines.end());
+		}
+
+		std::bernoulli_distribution given(given_ratio);
+
+		auto number_length = 0;
+		std::string empty_field;
+		for (auto i = 1; i <= size; i *= 10)
+		{
+			++number_length;
+			empty_field += '_';
+		}
+
+		std::string limit_line;
+		for (auto x = 0; x < n; ++x)
+		{
+			limit_line += '+';
+			limit_line += std::string((number_length + 1) * n + 1, '-');
+		}
+		limit_line += '+';
+
+		std::ofstream file(path_ss.str());
+		file << "experiment: generator (given ratio: " << given_ratio << ")\n";
+		file << "number of tasks: 1\n";
+		file << "task: 1\n";
+		file << "puzzle size: " << size << "x" << size << "\n";
+
+		for (auto y = 0; y < size; ++y)
+		{
+			if (y % n == 0) file << limit_line << "\n";
+
+			for (auto x = 0; x < size; ++x)
+			{
+				if (x % n == 0) file << "| ";
+
+				if (!given(random))
+				{
+					file << empty_field << ' ';
+					continue;
+				}
+
+				const auto row = rows[y];
+				const auto column = columns[x];
+				const auto number = digits[(n * (row % n) + row / n + column) % size];
+
+				file << std::setw(number_length) << number << ' ';
+			}
+			file << "|\n";
+		}
+		file << limit_line << "\n";
+	}
+}
+
+void solve_sudoku(std::string path, std::string solver, std::string outputfile, bool verbose, bool omit_output,
+				  const EncodingOptions& encoding_options, const ParallelOptions& parallel_options, const std::string& scratch_prefix,
+				  const ReuseOptions& reuse)
+{
+	ScopedTrace trace("solve_sudoku", "solve");
+
+	const auto cache = reuse.cache;
 	//record time taken
 	auto sudoku_start = std::chrono::steady_clock::now();
-	std::string cnf_filename = "clauses_out.cnf";
-	std::string solution_filename = "model.txt";
+	const auto in_memory = parallel_options.memory_scratch;
+	std::vector<ScratchFile> scratch_files;
+	const auto solution_filename = get_scratch_path(scratch_prefix + "model.txt", in_memory, &scratch_files);
 
 	if (verbose) std::cout << "Solving Sudoku at \"" << path << "\"" << std::endl;
 
-	Sudoku sudoku(path, verbose);
+	//a checkpoint saves reading and preprocessing
+	const auto checkpoint_path = reuse.checkpoint_directory.empty() ? "" : get_checkpoint_path(reuse.checkpoint_directory, path);
+	std::unique_ptr<Sudoku> sudoku_object;
+	if (!checkpoint_path.empty()) sudoku_object = Sudoku::resume(path, checkpoint_path, verbose);
+	const auto resumed = sudoku_object != nullptr;
+	if (!resumed) sudoku_object.reset(new Sudoku(path, verbose));
+
+	auto& sudoku = *sudoku_object;
+	sudoku.set_scratch_files(get_scratch_path(scratch_prefix + "temp_clauses.txt", in_memory, &scratch_files),
+							 get_scratch_path(scratch_prefix + "clauses_out.cnf", in_memory, &scratch_files));
+	const auto cnf_filename = sudoku.get_clauses_filename();
 
 	const auto size = sudoku.get_size();
+	if (!size) return;			//the file couldn't be read, that was already reported
 
 	if (verbose) 
 	{
@@ -210,7 +1509,25 @@ void solve_sudoku(std::string path, std::string solver, std::string outputfile,
 
 	if (verbose) std::cout << known_numbers_before << " of " << size * size << " cells are filled." << std::endl;
 
-	if (SIMPLE_SOLVING_ENABLED)
+	//a sudoku of the same symmetry class was solved before, its solution only has to be transformed back
+	CanonicalSudoku canonical;
+	if (cache)
+	{
+		std::vector<int> cells, solution;
+		sudoku.get_cells(&cells);
+		if (cache->lookup(cells, size, &canonical, &solution) && sudoku.load(solution))
+		{
+			if (!omit_output) sudoku.print();
+
+			const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - sudoku_start).count() / 1000.;
+			std::cout << "Answered from the cache in " << time << " seconds" << std::endl;
+
+			//no benchmark row, it would show a solve without atoms, clauses or solver time
+			return;
+		}
+	}
+
+	if (SIMPLE_SOLVING_ENABLED && !resumed)
 		sudoku.simple_solve();
 
 	const auto known_numbers_after = sudoku.get_solved_fields();
@@ -221,36 +1538,135 @@ void solve_sudoku(std::string path, std::string solver, std::string outputfile,
 	if (size <= MAX_PRINT_SIZE && verbose)
 		sudoku.print();
 
+	sudoku.set_encoding_options(encoding_options);
+
 	sudoku.create_lut();
 
+	if (!checkpoint_path.empty() && !resumed && !sudoku.write_checkpoint(checkpoint_path))
+		std::cerr << "Couldn't write the checkpoint \"" << checkpoint_path << "\"." << std::endl;
+
 	sudoku.generate_all_clauses();
 
 	sudoku.write_clauses();
 
+	//split the search space if cube and conquer is requested, no cubes means there's nothing left to split
+	std::vector<std::vector<int>> cubes;
+	if (parallel_options.cubes > 1)
+		cubes = sudoku.generate_cubes(parallel_options.cubes);
+
+	const auto jobs = parallel_options.jobs > 0 ? parallel_options.jobs : std::max(1u, std::thread::hardware_concurrency());
+
 	//now execute the solver
 
 	if (verbose) std::cout << "Using solver " << solver << "..." << std::endl;
 
-	std::stringstream syscall;
-	syscall << solver;
-	syscall << " " << cnf_filename << " > " << solution_filename;
+	const auto adapter = SolverAdapter::get(solver);
+	std::vector<std::string> cnf_filenames;
+	std::vector<std::string> solution_filenames;
+
+	if (cubes.empty())
+	{
+		cnf_filenames.push_back(cnf_filename);
+		solution_filenames.push_back(solution_filename);
+	}
+	else
+	{
+		if (verbose) std::cout << "Split into " << cubes.size() << " cubes, solving them with " << jobs << " jobs..." << std::endl;
+
+		for (unsigned i = 0; i < cubes.size(); ++i)
+		{
+			cnf_filenames.push_back(get_scratch_path(scratch_prefix + "clauses_cube" + std::to_string(i) + ".cnf", in_memory, &scratch_files));
+			solution_filenames.push_back(get_scratch_path(scratch_prefix + "model_cube" + std::to_string(i) + ".txt", in_memory, &scratch_files));
+			sudoku.write_cube_clauses(cnf_filenames.back(), cubes[i]);
+		}
+	}
+
 	//I'm confused about if it's better to search for all models or not
-	
+	std::stringstream syscall;
+	syscall << adapter.get_command(cnf_filenames[0], solution_filenames[0]);
+	syscall << " > " << adapter.get_stdout_path(solution_filenames[0]);
+
 	if (verbose) std::cout << "Executing " << syscall.str() << "..." << std::endl;
 
-	auto time_pre_syscall = std::chrono::steady_clock::now() - sudoku_start;
+	const auto limited = parallel_options.limits.wall_seconds > 0 || parallel_options.limits.cpu_seconds > 0;
+
+	auto time_pre_syscall = std::chrono::steady_clock::now() - sudoku_start;
+
+	struct rusage solver_usage{};
+	auto solver_cpu_seconds = 0.;
+	int solved_by;
+	if (cubes.empty() && !limited)
+	{
+		solved_by = 0;
+		int ret = system_call(syscall.str(), &solver_usage);
+		if (ret == -1) {
+			if (verbose) std::cout << "Couldn't execute solver, exiting..." << std::endl;
+			return;
+		}
+		solver_cpu_seconds = get_cpu_seconds(solver_usage);
+	}
+	else
+	{
+		//a single solver under limits is a portfolio of one
+		int answer;
+		solved_by = run_solvers_until_answer(adapter, cnf_filenames, solution_filenames, jobs, cubes.empty(), &answer, &solver_usage, &solver_cpu_seconds,
+											 parallel_options.limits, verbose);
+	}
+
+	auto time_after_syscall_start = std::chrono::steady_clock::now();
+	auto time_solver = time_after_syscall_start - sudoku_start - time_pre_syscall;
+	const auto solver_seconds = std::chrono::duration_cast<std::chrono::milliseconds>(time_solver).count() / 1000.;
 
-	int ret = system_call(syscall.str());
-	if (ret == -1) {
-		if (verbose) std::cout << "Couldn't execute solver, exiting..." << std::endl;
-		return;
+	if (!cubes.empty())
+	{
+		//the cubes are other problems than the whole cnf and are stopped by the first model, so their cpu time
+		//only tells how busy the jobs were, not how long a single solver would have taken
+		const auto utilization = solver_seconds > 0 ? solver_cpu_seconds / (solver_seconds * jobs) : 1.;
+		std::cout << "Cube and conquer solved " << cubes.size() << " cubes with " << jobs << " jobs in " << solver_seconds
+				  << " seconds, " << solver_cpu_seconds << " seconds of solver time, utilization " << utilization * 100 << "%" << std::endl;
+
+		if (parallel_options.cube_speedup)
+		{
+			const auto single_start = std::chrono::steady_clock::now();
+			int single_answer;
+			struct rusage single_usage{};
+			double single_cpu_seconds;
+			const auto single_model = get_scratch_path(scratch_prefix + "model_single.txt", in_memory, &scratch_files);
+			run_solvers_until_answer(adapter, {cnf_filename}, {single_model}, 1, true, &single_answer, &single_usage, &single_cpu_seconds,
+									 parallel_options.limits);
+			const auto single_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - single_start).count();
+			if (!in_memory) std::remove(single_model.c_str());
+
+			std::cout << "A single solver on the whole cnf took " << single_seconds << " seconds, speedup "
+					  << (solver_seconds > 0 ? single_seconds / solver_seconds : 1.) << " with " << jobs << " jobs" << std::endl;
+		}
 	}
 
-	auto time_after_syscall_start = std::chrono::steady_clock::now();
+	if (solved_by == -1 && limited)
+		std::cerr << "The solver found no solution within the limits!" << std::endl;
+	else if (solved_by == -1)
+		std::cerr << "The solver found no solution, this Sudoku is unsolvable!" << std::endl;
 
 	if (verbose) std::cout << "Reading solution... " << std::endl;
 
-	sudoku.read_solution(solution_filename);
+	if (solved_by != -1)
+		sudoku.read_solution(solution_filenames[solved_by], adapter.format);
+
+	if (cache && sudoku.get_solved_fields() == size * size)
+	{
+		std::vector<int> solution;
+		sudoku.get_cells(&solution);
+		cache->add(canonical, solution);
+	}
+
+	if (!cubes.empty() && !in_memory)
+	{
+		for (unsigned i = 0; i < cnf_filenames.size(); ++i)
+		{
+			std::remove(cnf_filenames[i].c_str());
+			std::remove(solution_filenames[i].c_str());
+		}
+	}
 
 	if (!omit_output)
 		sudoku.print();
@@ -265,99 +1681,317 @@ void solve_sudoku(std::string path, std::string solver, std::string outputfile,
 	auto time = std::chrono::duration_cast<std::chrono::milliseconds>(sudoku_time).count() / 1000.;
 
 	if (outputfile != "") {
-		std::ofstream benchmark_file(outputfile, std::ofstream::out | std::ofstream::app);
-		benchmark_file << path << "," << sudoku.get_size() << "," << sudoku.get_ce_size() << "," << sudoku.get_unused_atom() - 1 
-			  << "," << sudoku.get_number_of_clauses() << "," << time << "\n" << std::flush;
+		BenchmarkRow row;
+		row.path = path;
+		row.seconds = time;
+		row.solver_seconds = solver_seconds;
+		row.solver_max_rss = solver_usage.ru_maxrss;
+		row.cubes = std::max<int>(cubes.size(), 1);
+		row.jobs = cubes.empty() ? 1 : jobs;
+		row.solver_cpu_seconds = solver_cpu_seconds;
+		row.solver = solver;
+		append_benchmark_row(outputfile, &sudoku, row, encoding_options);
+	}
+}
+
+void write_benchmark_header(const std::string& outputfile)
+{
+	std::ofstream benchmark(outputfile);
+
+	//a new benchmark also starts a new encoding report
+	std::ofstream encoding_report(get_encoding_report_path(outputfile));
+	benchmark << "Sudoku,Size,CE-Size,No. Atoms,No. Clauses,Seconds,Solver Seconds,Solver Max RSS (KB),Ordering,Clause Order,Commanders,Cubes,Jobs,Solver CPU Seconds,Solver"
+			  << ",Encoder Max RSS (KB),Candidate Bytes,Fixed Cell Bytes,LUT Bytes,Reverse LUT Bytes,Clause Buffer Bytes,Preprocessing Buffer Bytes"
+			  << ",IO Buffer Bytes,Sudoku Bytes\n";
+}
 
-		benchmark_file.close();
+void append_benchmark_row(const std::string& outputfile, Sudoku* sudoku, const BenchmarkRow& row, const EncodingOptions& encoding_options)
+{
+	//batch jobs share the file, every row has to be written in one piece
+	static std::mutex benchmark_file_mutex;
+	std::lock_guard<std::mutex> lock(benchmark_file_mutex);
+
+	//the peak of the encoder is the one of the whole process, with parallel jobs it's shared by all of their sudokus
+	const auto memory = sudoku->get_memory_usage();
+
+	std::ofstream benchmark_file(outputfile, std::ofstream::out | std::ofstream::app);
+	benchmark_file << row.path << "," << sudoku->get_size() << "," << sudoku->get_ce_size() << "," << sudoku->get_unused_atom() - 1 
+		  << "," << sudoku->get_number_of_clauses() << "," << row.seconds
+		  << "," << row.solver_seconds
+		  << "," << row.solver_max_rss
+		  << "," << get_atom_ordering_name(encoding_options.ordering)
+		  << "," << (encoding_options.interleave_clauses ? "unit" : "family")
+		  << "," << (encoding_options.commanders_near_groups ? "near groups" : "appended")
+		  << "," << row.cubes << "," << row.jobs
+		  << "," << row.solver_cpu_seconds
+		  << "," << row.solver
+		  << "," << get_own_max_rss() << "," << memory.candidates << "," << memory.fixed_cells << "," << memory.lookup
+		  << "," << memory.reverse_lookup << "," << memory.clause_buffers << "," << memory.preprocessing_buffers << "," << memory.io_buffers
+		  << "," << memory.get_total() << "\n" << std::flush;
+
+	benchmark_file.close();
+
+	append_encoding_report(get_encoding_report_path(outputfile), row.path, sudoku->get_size(), row.solver, sudoku->get_encoding_statistics());
+}
+
+//forks a process for a command in its own process group, returns like fork()
+//the child must not allocate since other threads might hold locks, and it doesn't run signal_handler,
+//a kill that reaches it before the exec just ends it
+pid_t fork_command_process()
+{
+	sigset_t all_signals, previous_signals;
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_SETMASK, &all_signals, &previous_signals);
+
+	const auto pid = fork();
+
+	if (pid == 0)
+	{
+		for (auto signum : HANDLED_SIGNALS) signal(signum, SIG_DFL);
+		setpgid(0, 0);
 	}
+
+	pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+	return pid;
 }
 
-//system call using fork to be able to kill the command
-int system_call(std::string command)
+//returns true if there is an adapter for the solver, otherwise lists the supported ones
+bool check_solver(const std::string& solver)
+{
+	SolverAdapter adapter;
+	if (SolverAdapter::find(solver, &adapter)) return true;
+
+	std::cout << "Solver \"" << solver << "\" is not supported, possible are:";
+	for (const auto& name : SolverAdapter::get_names()) std::cout << " " << name;
+	std::cout << std::endl;
+	return false;
+}
+
+//returns the path to use for a scratch file, either name itself or a file in memory that lives as long as it is in files
+std::string get_scratch_path(const std::string& name, const bool in_memory, std::vector<ScratchFile>* files)
+{
+	if (!in_memory) return name;
+
+	files->push_back(ScratchFile(name));
+	return files->back().get_path();
+}
+
+//a scratch prefix with the pid, so processes running in the same folder don't share files
+std::string get_process_prefix(const std::string& name)
+{
+	return name + std::to_string(getpid()) + "_";
+}
+
+//the scratch prefix of a batch job
+std::string get_job_prefix(const int job)
 {
-	command_pid = fork();
+	return get_process_prefix("job") + std::to_string(job) + "_";
+}
+
+//starts the command in its own process group, so it can be killed together with everything it started
+pid_t start_command(const std::string& command)
+{
+	//exec lets the shell replace itself, so the wait status and usage are the ones of the command
+	//the string is built before the fork, the child of a process with threads must not allocate
+	const auto shell_command = "exec " + command;
+
+	const auto pid = fork_command_process();
 
-	if (command_pid < 0)
+	if (pid < 0)
 	{
 		std::cout << "Failed to fork!" << std::endl;
 		return -1;
 	}
 
-	if (command_pid == 0) 
+	if (pid == 0)
 	{
 		//child
 		//execute command here
-		system(command.c_str());
-		exit(1);
+		execl("/bin/sh", "sh", "-c", shell_command.c_str(), static_cast<char*>(nullptr));
+		_exit(127);
 	}
-	else
+
+	//also set in the parent, otherwise a kill right after the fork could miss the group
+	setpgid(pid, pid);
+	track_command(pid);
+
+	return pid;
+}
+
+void track_command(const pid_t pid)
+{
+	for (auto& slot : running_commands)
+	{
+		pid_t free_slot = 0;
+		if (slot.compare_exchange_strong(free_slot, pid)) break;
+	}
+}
+
+void untrack_command(const pid_t pid)
+{
+	for (auto& slot : running_commands)
 	{
-		//parent
-		int status;
-		wait(&status);
+		auto running = pid;
+		if (slot.compare_exchange_strong(running, 0)) break;
 	}
+}
+
+//waits for a command started with start_command, returns its wait status
+int finish_command(const pid_t pid, struct rusage* usage)
+{
+	int status = 0;
+	struct rusage command_usage{};
+	while (wait4(pid, &status, 0, &command_usage) == -1 && errno == EINTR) {}
+	if (usage) *usage = command_usage;
+
+	//not executing this command anymore...
+	untrack_command(pid);
+
+	return status;
+}
+
+//system call using fork to be able to kill the command
+//if usage is given it receives the resource usage of the command
+int system_call(std::string command, struct rusage* usage)
+{
+	ScopedTrace trace("solver", "solver");
 
-	//not executing any command anymore...
-	command_pid = -1;
+	const auto pid = start_command(command);
+	if (pid < 0) return -1;
+	trace.set_value(pid);
+
+	finish_command(pid, usage);
 	return 1;
 }
 
-void signal_handler(int signum)
+//runs the solver on the cnfs, at most jobs at the same time, until one of them finds a model
+//or, if stop_on_unsatisfiable is set, one of them proves its cnf unsatisfiable
+//the model of cnf i is written to model_paths[i], the solvers are watched by a SolverSupervisor
+//the other solvers are killed then, returns the index of that cnf or -1 if none answered
+//answer receives 1 for satisfiable and 0 for unsatisfiable, usage the resources of the answering solver
+//and cpu_seconds the cpu time of all of them
+int run_solvers_until_answer(const SolverAdapter& adapter, const std::vector<std::string>& cnf_paths, const std::vector<std::string>& model_paths,
+							 const int jobs, const bool stop_on_unsatisfiable, int* answer, struct rusage* usage, double* cpu_seconds,
+							 const SolverLimits& limits, const bool verbose)
 {
-	if (command_pid != -1)
+	SolverSupervisor supervisor(jobs, limits);
+	for (unsigned i = 0; i < cnf_paths.size(); ++i)
+		supervisor.add(adapter.get_command(cnf_paths[i], model_paths[i]), adapter.get_stdout_path(model_paths[i]));
+
+	auto result = -1;
+	*answer = -1;
+
+	supervisor.run([&](const int index) {
+		const auto& job = supervisor.get_job(index);
+
+		//trust the exit code if the solver follows the convention, otherwise look at its output
+		auto command_answer = -1;
+		if (job.exit_code == SATISFIABLE_EXIT_CODE) command_answer = 1;
+		else if (job.exit_code == UNSATISFIABLE_EXIT_CODE) command_answer = 0;
+		else if (!job.launch_failed && !job.wall_limit_exceeded && !job.cpu_limit_exceeded)
+			command_answer = adapter.read_status(model_paths[index]);
+
+		if (command_answer == 1 || (command_answer == 0 && stop_on_unsatisfiable))
+		{
+			result = index;
+			*answer = command_answer;
+			*usage = job.usage;
+			return true;
+		}
+		return false;
+	});
+
+	*cpu_seconds = 0;
+	for (auto i = 0; i < supervisor.get_number_of_jobs(); ++i)
 	{
-		kill(command_pid, signum);
+		const auto& job = supervisor.get_job(i);
+		*cpu_seconds += get_cpu_seconds(job.usage);
+
+		if (!verbose) continue;
+		std::cout << "Solver " << i << ": ";
+		if (job.launch_failed || job.pid == -1) std::cout << "not started";
+		else if (job.stopped) std::cout << "stopped";
+		else if (job.wall_limit_exceeded) std::cout << "wall time limit exceeded";
+		else if (job.cpu_limit_exceeded) std::cout << "cpu time limit exceeded";
+		else std::cout << "exit code " << job.exit_code;
+		std::cout << ", " << job.wall_seconds << " s wall, " << get_cpu_seconds(job.usage) << " s cpu, "
+				  << job.usage.ru_maxrss << " KB max rss" << std::endl;
 	}
 
-	exit(signum);
+	return result;
 }
 
-//adapted from https://www.geeksforgeeks.org/extract-integers-string-c/
-int get_first_integer(const std::string& str)
+double get_cpu_seconds(const struct rusage& usage)
 {
-	std::stringstream ss;
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+//the peak resident memory of this process in KB, the solvers are children and not part of it
+long get_own_max_rss()
+{
+	struct rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
 
-	ss << str;
+void signal_handler(int signum)
+{
+	for (auto& slot : running_commands)
+	{
+		const pid_t pid = slot;
+		if (pid > 0) kill(-pid, signum);
+	}
 
-	/* Running loop till the end of the stream */
-	std::string temp;
-	int found;
-	while (!ss.eof()) {
+	//the atexit handlers still run, the trace mustn't wait for a buffer the interrupted thread might hold
+	discard_trace();
+	exit(signum);
+}
 
-		/* extracting word by word from stream */
-		ss >> temp;
+//returns the commander encoding group size for a sudoku of order n
+int get_commander_encoding_size(const int n)
+{
+	if (n < COMMANDER_ENCODING_SIZES_COUNT && COMMANDER_ENCODING_SIZES[n])
+		return COMMANDER_ENCODING_SIZES[n];
 
-		/* Checking the given word is integer or not */
-		if (std::stringstream(temp) >> found)
-			return found;
+	//no measured size for this order
+	return COMMANDER_ENCODING_MAX_SIZE;
+}
 
-		/* To save from space at the end of string */
-		temp = "";
-	}
+//the checkpoint of a sudoku in the folder, named after the file and a hash of its path, so equally named sudokus of other folders don't collide
+std::string get_checkpoint_path(const std::string& directory, const std::string& sudoku_path)
+{
+	const auto slash = sudoku_path.rfind('/');
+	const auto name = slash == std::string::npos ? sudoku_path : sudoku_path.substr(slash + 1);
 
-	return -1;
+	std::stringstream path;
+	path << directory << "/" << name << "." << std::hex << std::hash<std::string>()(sudoku_path) << ".checkpoint";
+	return path.str();
 }
 
 Sudoku::Sudoku(std::string path, bool verbose): mPath(std::move(path)), mTemp_filename("temp_clauses.txt"), 
 												mClauses_output_filename("clauses_out.cnf"), mVerbose(verbose)
 {
-	this->init_size();
+	ScopedTrace trace("parse");
 
-	mExtra_atom_number = -1;			//initialize to invalid first, is initialized when requested
+	std::vector<int> cells;
+	if (!this->read_file(&cells)) mSolvable = false;
 
-	mLut.resize(mSize * mSize * mSize + 1, 0);
+	mExtra_atom_number = -1;			//initialize to invalid first, is initialized when requested
 
 	if (mVerbose) std::cout << "Sudoku of type " << mSize << "x" << mSize << "." << std::endl;
 
-	if (mN >= 3 && mN <= 15 && COMMANDER_ENCODING) {
-		mCommander_encoding_size = COMMANDER_ENCODING_SIZES[mN];
-		if (mVerbose) std::cout << "Using commander encoding with max group size " << mCommander_encoding_size << "." << std::endl;
-	}
+	mCommander_encoding_size = get_commander_encoding_size(mN);
 
 	init_matrix();
 
-	this->read_sudoku();
+	for (auto y = 0; y < mSize; ++y)
+	{
+		for (auto x = 0; x < mSize; ++x)
+		{
+			const auto number = cells[std::size_t(y) * mSize + x];
+			if (number) this->set_field(x, y, number - 1);
+		}
+	}
 }
 
 Sudoku::Sudoku(const std::string& solution_path, const std::string& lut_path)
@@ -376,40 +2010,51 @@ Sudoku::Sudoku(const std::string& solution_path, const std::string& lut_path)
 	this->print_out("solved.txt");
 }
 
-Sudoku::~Sudoku() = default;
-
-void Sudoku::init_size()
+Sudoku::Sudoku(const int size, const bool verbose): mSize(size), mN(int(std::sqrt(size))), mTemp_filename("temp_clauses.txt"),
+													mClauses_output_filename("clauses_out.cnf"), mVerbose(verbose)
 {
-	std::ifstream file(mPath);
+	mExtra_atom_number = -1;
+	mCommander_encoding_size = get_commander_encoding_size(mN);
 
-	if (!file.is_open()) return;
+	init_matrix();
+}
 
-	std::string content;
+Sudoku::~Sudoku() = default;
 
-	//read first header line to check format
-	std::getline(file, content);
-	if (!content.rfind("experiment:", 0)) {
-		//standard test sudokus, continue to read rest of header lines
-		for (auto i = 0; i < HEADER_LINES - 1; ++i) {
-			std::getline(file, content);
-		}
+void Sudoku::reset()
+{
+	//the buffers keep their size, only their content is reset
+	mSudoku_matrix.fill();
+	std::fill(mFixed_cell.begin(), mFixed_cell.end(), false);
+	mSolvable = true;
+	mUnsolvable_cell_x = -1;
+	mUnsolvable_cell_y = -1;
+	mNumber_of_clauses = 0;
+	mNumber_of_atoms = 0;
+	mExtra_atom_number = -1;
+	mEncoding_statistics.reset();
+	mCommander_encoding_size = get_commander_encoding_size(mN);
+}
 
-		const auto pos = content.find('x');
-		content.erase(pos);					//delete part after the x so only one integer can be found
+bool Sudoku::load(const std::vector<int>& cells)
+{
+	ScopedTrace trace("load");
 
-		mSize = get_first_integer(content);
+	if (cells.size() != std::size_t(mSize) * mSize) return false;
 
-	} else {
-		//format from sudoku reader -> only two header lines
-		std::getline(file, content);
+	reset();
 
-		//this can only be a 3-Sudoku, the reader only reads 3-Sudokus
-		mSize = 9;
+	for (auto y = 0; y < mSize; ++y)
+	{
+		for (auto x = 0; x < mSize; ++x)
+		{
+			const auto number = cells[std::size_t(y) * mSize + x];
+			if (number < 0 || number > mSize) return false;
+			if (number) this->set_field(x, y, number - 1);
+		}
 	}
 
-	mN = int(std::sqrt(mSize));
-
-	file.close();
+	return true;
 }
 
 void Sudoku::init_matrix()
@@ -417,69 +2062,28 @@ void Sudoku::init_matrix()
 	if (mVerbose) std::cout << "Initializing matrix... " << std::flush;
 
 	//initialize the sudoku matrix with all ones
-	this->mSudoku_matrix.resize(mSize);
-	this->mFixed_cell.resize(mSize);
-	for (auto i = 0; i < mSize; ++i)
-	{
-		this->mSudoku_matrix[i].resize(mSize);
-		this->mFixed_cell[i].resize(mSize, false);
-		for (auto j = 0; j < mSize; ++j)
-		{
-			this->mSudoku_matrix[i][j].resize(mSize, true);
-		}
-	}
+	this->mSudoku_matrix.init(mSize);
+	this->mFixed_cell.assign(std::size_t(mSize) * mSize, false);
 	if (mVerbose) std::cout << "Done!" << std::endl;
 }
 
-void Sudoku::read_sudoku()
+bool Sudoku::read_file(std::vector<int>* cells)
 {
-	std::ifstream file(mPath);
-	std::string content;
-
-	//read first header line to check format
-	std::getline(file, content);
-	if (content.rfind("experiment:", 0) == 0) {
-		//standard test sudokus, continue to read rest of header lines
-		for (auto i = 0; i < HEADER_LINES - 1; ++i) {
-			std::getline(file, content);
-		}
-	} 
-	else if (content.rfind("+", 0) == 0) {
-		//only sudoku in the file, this is delimiter line, do nothing
-	}
-	else {
-		//format from sudoku reader -> only two header lines
-		std::getline(file, content);
-	}
+	if (mVerbose) std::cout << "Reading Sudoku... " << std::flush;
 
-	std::string empty_field;
-	for (auto i = 1; i <= mSize; i *= 10) empty_field += "_";
-
-	//reading the sudoku
-	for (auto y = 0; y < mSize; ++y)
+	//the file is mapped and scanned once, the size comes from the same pass
+	if (!read_sudoku_file(mPath, cells, &mSize))
 	{
-		if (mVerbose) std::cout << "\rReading Sudoku... line " << y+1 << "/" << mSize << " " << std::flush;
-		std::getline(file, content);
-		if (content.find('+') != std::string::npos) std::getline(file, content);		//if this is a delimiter line, skip it
-
-		std::stringstream stream;
-		stream << content;
-		std::string number;
-		for (auto x = 0; x < mSize; ++x)
-		{
-			stream >> number;
-			if (number == "|") stream >> number;	//if this is a delimiter char, skip it
-			if (number != empty_field)				//if this field is empty, skip it
-			{										//otherwise read number and fill field
-				int field_number;
-				std::stringstream(number) >> field_number;
-				if (field_number)					//a number may be 0 if there's actually no number there (different input format)
-					this->set_field(x, y, field_number - 1);
-			}
-		}
+		std::cerr << "Couldn't read the Sudoku at \"" << mPath << "\"." << std::endl;
+		mSize = 0;
+		mN = 0;
+		return false;
 	}
 
+	mN = int(std::sqrt(mSize));
+
 	if (mVerbose) std::cout << "Done!" << std::endl;
+	return true;
 }
 
 bool Sudoku::set_field(const int row_x, const int row_y, const int number)
@@ -488,16 +2092,16 @@ bool Sudoku::set_field(const int row_x, const int row_y, const int number)
 	if (number >= mSize || number < 0) return false;
 	if (row_x >= mSize || row_x < 0) return false;
 	if (row_y >= mSize || row_y < 0) return false;
-	if (mFixed_cell[row_x][row_y]) return false;		//if this cell is already set
+	if (mFixed_cell[std::size_t(row_x) * mSize + row_y]) return false;		//if this cell is already set
 
-	mFixed_cell[row_x][row_y] = true;
+	mFixed_cell[std::size_t(row_x) * mSize + row_y] = true;
+
+	mSudoku_matrix.set_only(row_x, row_y, number);		//set this field
 
 	for (auto i = 0; i < mSize; ++i)
 	{
-		mSudoku_matrix[row_x][row_y][i] = number == i;		//set this field
-
-		if (i != row_x)	mSudoku_matrix[i][row_y][number] = false;	//set the column
-		if (i != row_y) mSudoku_matrix[row_x][i][number] = false;	//set the row
+		if (i != row_x)	mSudoku_matrix.clear(i, row_y, number);	//set the column
+		if (i != row_y) mSudoku_matrix.clear(row_x, i, number);	//set the row
 	}
 
 	//set the section
@@ -510,7 +2114,7 @@ bool Sudoku::set_field(const int row_x, const int row_y, const int number)
 		{
 			if (row_x != x_i && row_y != y_i)	//don't for the field we're actually setting
 			{
-				mSudoku_matrix[x_i][y_i][number] = false;
+				mSudoku_matrix.clear(x_i, y_i, number);
 			}
 		}
 	}
@@ -520,6 +2124,8 @@ bool Sudoku::set_field(const int row_x, const int row_y, const int number)
 
 void Sudoku::simple_solve()
 {
+	ScopedTrace trace("preprocess");
+
 	//use the simple_solve functions as long as they still do something
 
 	auto counter = 0;
@@ -527,6 +2133,7 @@ void Sudoku::simple_solve()
 	do
 	{
 		++counter;
+		ScopedTrace iteration_trace("iteration", "preprocess", counter);
 		if (mVerbose) std::cout << "\rSimple-Solving in iteration " << counter << "... " << std::flush;
 		keep_going = false;
 
@@ -559,11 +2166,13 @@ void Sudoku::simple_solve()
 
 bool Sudoku::naked_singles()
 {
+	ScopedTrace trace("naked_singles", "rule");
+
 	auto result = false;
 	for (auto x = 0; x < mSize; ++x) {
 		for (auto y = 0; y < mSize; ++y) {
 			auto n = get_number_at_position(x, y);
-			if (n != -1 && !mFixed_cell[x][y])		//if there's a number there but not entered in the fixed cell matrix
+			if (n != -1 && !mFixed_cell[std::size_t(x) * mSize + y])		//if there's a number there but not entered in the fixed cell matrix
 			{
 				set_field(x, y, n);
 				result = true;
@@ -575,24 +2184,24 @@ bool Sudoku::naked_singles()
 
 bool Sudoku::naked_candidates()
 {
+	ScopedTrace trace("naked_candidates", "rule");
+
 	auto result = false;
 
 	for (auto x = 0; x < mSize; ++x) {
 		for (auto y = 0; y < mSize; ++y) {
 			//skip already fixed cells
-			if (mFixed_cell[x][y]) continue;
-
-			//copy this cell
-			auto numbers = mSudoku_matrix[x][y];
+			if (mFixed_cell[std::size_t(x) * mSize + y]) continue;
 
-			auto m = 0;
-			for (auto n = 0; n < mSize; ++n) m += numbers[n];
+			//the numbers of this cell, the cell itself is never changed below
+			const unsigned m = mSudoku_matrix.count(x, y);
 
-			std::vector<int> found{x};
+			auto& found = mFound_cells;
+			found.assign(1, x);
 
 			//go through same column to check for cells with exactly same numbers in them
 			for (auto x_i = x+1; x_i < mSize; ++x_i) {
-				if (numbers == mSudoku_matrix[x_i][y]) {
+				if (mSudoku_matrix.same_numbers(x, y, x_i, y)) {
 					found.push_back(x_i);
 				}
 			}
@@ -605,20 +2214,19 @@ bool Sudoku::naked_candidates()
 						if (found.size()) found.erase(found.begin());
 					} else {
 						for (auto n_i = 0; n_i < mSize; ++n_i) {
-							if (numbers[n_i]) {
-								if (!result && mSudoku_matrix[x_i][y][n_i]) result = true;
-								mSudoku_matrix[x_i][y][n_i] = false;
+							if (mSudoku_matrix.get(x, y, n_i)) {
+								if (mSudoku_matrix.clear(x_i, y, n_i)) result = true;
 							}
 						}
 					}
 				}
 			}
 
-			found = {y};
+			found.assign(1, y);
 
 			//go through same row to check for cells with exactly same numbers in them
 			for (auto y_i = y+1; y_i < mSize; ++y_i) {
-				if (numbers == mSudoku_matrix[x][y_i]) {
+				if (mSudoku_matrix.same_numbers(x, y, x, y_i)) {
 					found.push_back(y_i);
 				}
 			}
@@ -631,9 +2239,8 @@ bool Sudoku::naked_candidates()
 						if (found.size()) found.erase(found.begin());
 					} else {
 						for (auto n_i = 0; n_i < mSize; ++n_i) {
-							if (numbers[n_i]) {
-								if (!result && mSudoku_matrix[x][y_i][n_i]) result = true;
-								mSudoku_matrix[x][y_i][n_i] = false;
+							if (mSudoku_matrix.get(x, y, n_i)) {
+								if (mSudoku_matrix.clear(x, y_i, n_i)) result = true;
 							}
 						}
 					}
@@ -647,6 +2254,8 @@ bool Sudoku::naked_candidates()
 
 bool Sudoku::hidden_singles_columns()
 {
+	ScopedTrace trace("hidden_singles_columns", "rule");
+
 	auto result = false;
 	for (auto x = 0; x < mSize; ++x)
 	{
@@ -656,7 +2265,7 @@ bool Sudoku::hidden_singles_columns()
 			auto y_pos = -1;
 			for (auto y = 0; y < mSize; ++y)
 			{
-				if (mSudoku_matrix[x][y][n])
+				if (mSudoku_matrix.get(x, y, n))
 				{
 					if (y_pos == -1) y_pos = y;
 					else
@@ -680,6 +2289,8 @@ bool Sudoku::hidden_singles_columns()
 
 bool Sudoku::hidden_singles_rows()
 {
+	ScopedTrace trace("hidden_singles_rows", "rule");
+
 	auto result = false;
 
 	for (auto y = 0; y < mSize; ++y)
@@ -690,7 +2301,7 @@ bool Sudoku::hidden_singles_rows()
 			auto x_pos = -1;
 			for (auto x = 0; x < mSize; ++x)
 			{
-				if (mSudoku_matrix[x][y][n])
+				if (mSudoku_matrix.get(x, y, n))
 				{
 					if (x_pos == -1) x_pos = x;
 					else
@@ -714,6 +2325,8 @@ bool Sudoku::hidden_singles_rows()
 
 bool Sudoku::hidden_singles_section()
 {
+	ScopedTrace trace("hidden_singles_section", "rule");
+
 	auto result = false;
 
 	for (auto section_x = 0; section_x < mN; ++section_x) {
@@ -728,7 +2341,7 @@ bool Sudoku::hidden_singles_section()
 				{
 					for (auto y_i = section_y * mN; y_i < (section_y + 1)*mN; ++y_i)
 					{
-						if (mSudoku_matrix[x_i][y_i][n])
+						if (mSudoku_matrix.get(x_i, y_i, n))
 						{
 							if (x_pos == -1)
 							{
@@ -761,6 +2374,8 @@ bool Sudoku::hidden_singles_section()
 
 bool Sudoku::pointing_candidates()
 {
+	ScopedTrace trace("pointing_candidates", "rule");
+
 	auto result = false;
 
 	for (auto n = 0; n < mSize; ++n)	//go through all the numbers
@@ -768,11 +2383,14 @@ bool Sudoku::pointing_candidates()
 		for (auto section_x = 0; section_x < mN; ++section_x) {	//go through all the sections
 			for (auto section_y = 0; section_y < mN; ++section_y) {
 
-				std::vector<int> occurrences_x, occurrences_y;
+				auto& occurrences_x = mOccurrences_x;
+				auto& occurrences_y = mOccurrences_y;
+				occurrences_x.clear();
+				occurrences_y.clear();
 
 				for (auto x_i = section_x * mN; x_i < (section_x + 1)*mN; ++x_i) {	//go through the section
 					for (auto y_i = section_y * mN; y_i < (section_y + 1)*mN; ++y_i) {
-						if (!mSudoku_matrix[x_i][y_i][n]) continue;
+						if (!mSudoku_matrix.get(x_i, y_i, n)) continue;
 						occurrences_x.push_back(x_i);		//collect all occurrences of one number in the section
 						occurrences_y.push_back(y_i);
 					}
@@ -801,8 +2419,7 @@ bool Sudoku::pointing_candidates()
 							y += mN - 1; //skip section we're in
 							continue;
 						}
-						if (!result && mSudoku_matrix[x_align][y][n]) result = true;
-						mSudoku_matrix[x_align][y][n] = false;
+						if (mSudoku_matrix.clear(x_align, y, n)) result = true;
 					}
 				}
 				if (y_aligned)
@@ -814,8 +2431,7 @@ bool Sudoku::pointing_candidates()
 							x += mN - 1; //skip section we're in
 							continue;
 						}
-						if (!result && mSudoku_matrix[x][y_align][n]) result = true;
-						mSudoku_matrix[x][y_align][n] = false;
+						if (mSudoku_matrix.clear(x, y_align, n)) result = true;
 					}
 				}
 			}
@@ -827,6 +2443,8 @@ bool Sudoku::pointing_candidates()
 
 bool Sudoku::box_line_reduction()
 {
+	ScopedTrace trace("box_line_reduction", "rule");
+
 	auto result = false;
 
 	for (auto n = 0; n < mSize; ++n)	//for all numbers
@@ -840,7 +2458,7 @@ bool Sudoku::box_line_reduction()
 			auto count = 0;
 			for (auto y = 0; y < mSize; ++y)
 			{
-				if (!mSudoku_matrix[x][y][n]) continue;
+				if (!mSudoku_matrix.get(x, y, n)) continue;
 				if (section_y == -1) section_y = y / mN;
 				else if (section_y != y / mN) {
 					possible = false;
@@ -853,8 +2471,7 @@ bool Sudoku::box_line_reduction()
 				for (auto x_i = section_x * mN; x_i < (section_x + 1)*mN; ++x_i) {		//iterate through the single section
 					for (auto y_i = section_y * mN; y_i < (section_y + 1)*mN; ++y_i) {
 						if (x_i == x) continue;	//don't delete the n on the line we're searching
-						if (!result && mSudoku_matrix[x_i][y_i][n]) result = true;
-						mSudoku_matrix[x_i][y_i][n] = false;
+						if (mSudoku_matrix.clear(x_i, y_i, n)) result = true;
 					}
 				}
 			}
@@ -869,7 +2486,7 @@ bool Sudoku::box_line_reduction()
 			auto count = 0;
 			for (auto x = 0; x < mSize; ++x)
 			{
-				if (!mSudoku_matrix[x][y][n]) continue;
+				if (!mSudoku_matrix.get(x, y, n)) continue;
 				if (section_x == -1) section_x = x / mN;
 				else if (section_x != x / mN) {
 					possible = false;
@@ -882,8 +2499,7 @@ bool Sudoku::box_line_reduction()
 				for (auto x_i = section_x * mN; x_i < (section_x + 1)*mN; ++x_i) {		//iterate through the single section
 					for (auto y_i = section_y * mN; y_i < (section_y + 1)*mN; ++y_i) {
 						if (y_i == y) continue;	//don't delete the n on the line we're searching
-						if (!result && mSudoku_matrix[x_i][y_i][n]) result = true;
-						mSudoku_matrix[x_i][y_i][n] = false;
+						if (mSudoku_matrix.clear(x_i, y_i, n)) result = true;
 					}
 				}
 			}
@@ -895,6 +2511,8 @@ bool Sudoku::box_line_reduction()
 
 bool Sudoku::x_wing()
 {
+	ScopedTrace trace("x_wing", "rule");
+
 	auto result = false;
 
 	for (auto n = 0; n < mSize; ++n)	//for all numbers
@@ -907,7 +2525,7 @@ bool Sudoku::x_wing()
 			int n1_y = -1;
 			int n2_y = -1;
 			for (auto y = 0; y < mSize; ++y) {
-				if (mSudoku_matrix[x][y][n]) {
+				if (mSudoku_matrix.get(x, y, n)) {
 					if (n1_y == -1) n1_y = y;
 					else if (n2_y == -1) n2_y = y;
 					else { //found too many n
@@ -926,10 +2544,8 @@ bool Sudoku::x_wing()
 						//found x_wing! -> eliminate all n in rows y1 and y2
 						for (auto x_remove = 0; x_remove < mSize; ++x_remove) {
 							if (x_remove == x || x_remove == candidate.pos3) continue;
-							if (!result && mSudoku_matrix[x_remove][n1_y][n]) result = true;	//notice if anything is actually being done
-							if (!result && mSudoku_matrix[x_remove][n2_y][n]) result = true;
-							mSudoku_matrix[x_remove][n1_y][n] = false;
-							mSudoku_matrix[x_remove][n2_y][n] = false;
+							if (mSudoku_matrix.clear(x_remove, n1_y, n)) result = true;	//notice if anything is actually being done
+							if (mSudoku_matrix.clear(x_remove, n2_y, n)) result = true;
 						}
 					}
 				}
@@ -946,7 +2562,7 @@ bool Sudoku::x_wing()
 			int n1_x = -1;
 			int n2_x = -1;
 			for (auto x = 0; x < mSize; ++x) {
-				if (mSudoku_matrix[x][y][n]) {
+				if (mSudoku_matrix.get(x, y, n)) {
 					if (n1_x == -1) n1_x = x;
 					else if (n2_x == -1) n2_x = x;
 					else { //found too many n
@@ -965,10 +2581,8 @@ bool Sudoku::x_wing()
 						//found x_wing! -> eliminate all n in columns x1 and x2
 						for (auto y_remove = 0; y_remove < mSize; ++y_remove) {
 							if (y_remove == y || y_remove == candidate.pos3) continue;
-							if (!result && mSudoku_matrix[n1_x][y_remove][n]) result = true;	//notice if anything is actually being done
-							if (!result && mSudoku_matrix[n2_x][y_remove][n]) result = true;
-							mSudoku_matrix[n1_x][y_remove][n] = false;
-							mSudoku_matrix[n2_x][y_remove][n] = false;
+							if (mSudoku_matrix.clear(n1_x, y_remove, n)) result = true;	//notice if anything is actually being done
+							if (mSudoku_matrix.clear(n2_x, y_remove, n)) result = true;
 						}
 					}
 				}
@@ -986,133 +2600,64 @@ int Sudoku::get_number_at_position(const int x, const int y)
 	if (x >= mSize || x < 0) return -1;
 	if (y >= mSize || y < 0) return -1;
 
-	auto result = -1;
-	for (auto i = 0; i < mSize; ++i)
-	{
-		if (mSudoku_matrix[x][y][i]) {
-			if (result == -1) result = i;
-			else return -1;					//if there are multiple numbers possible here then we're not sure what number is here
-		}
-		if (i == mSize - 1 && result == -1 && mSolvable) {
+	//-1 if there are multiple numbers possible here, then we're not sure what number is here
+	const auto result = mSudoku_matrix.get_single(x, y);
+	if (result == -2) {
+		if (mSolvable) {
 			mUnsolvable_cell_x = x;
 			mUnsolvable_cell_y = y;
 			mSolvable = false;				//this can't happen on a solvable sudoku
 		}
+		return -1;
 	}
 	return result;
 }
 
 void Sudoku::print()
 {
-	auto solved_fields = 0;
-
-	auto number_length = 0;
-	std::string empty_field;
-	for (auto i = 1; i <= mSize; i *= 10)
-	{
-		++number_length;		
-		empty_field += '_';
-	}
-	empty_field += ' ';
-
-	std::string limit_line;
-	for (auto x = 0; x < mN; ++x)
-	{
-		limit_line += '+';
-		for (auto i = 0; i < (number_length + 1) * mN + 1; ++i) limit_line += '-';
-	}
-	limit_line += '+';
-
-	for (auto y = 0; y < mSize; ++y)
-	{
-		if (y % mN == 0)
-		{
-			//draw limiter line
-			std::cout << limit_line << "\n";
-		}
-
-		for (auto x = 0; x < mSize; ++x)
-		{
-			if (x % mN == 0)
-			{
-				//draw limiter char
-				std::cout << "| ";
-			}
-
-			auto number = get_number_at_position(x, y);
-			if (number == -1) std::cout << empty_field;
-			else {
-				number++;
-				auto n = 0;
-				for (auto i = 1; i <= number; i *= 10) ++n;
-				for (auto i = n; i < number_length; ++i) std::cout << ' ';
-				std::cout << number << ' ';
-				++solved_fields;
-			}
-		}
-		std::cout << "|\n";
-	}
-	std::cout << limit_line << std::endl;
-	//std::cout << "Solved fields: " << solved_fields << "/" << mSize * mSize << std::endl;
+	std::string grid;
+	render(&grid);
+	std::cout.write(grid.data(), std::streamsize(grid.size()));
+	std::cout.flush();
 }
 
 void Sudoku::print_out(std::string path)
 {
 	if (mVerbose) std::cout << "Printing solved sudoku to " << path << "... ";
 
+	std::string grid;
+	render(&grid);
+
 	std::ofstream file(path);
+	file.write(grid.data(), std::streamsize(grid.size()));
 
-	auto solved_fields = 0;
+	if (mVerbose) std::cout << "Done!" << std::endl;
+}
 
-	auto number_length = 0;
-	std::string empty_field;
-	for (auto i = 1; i <= mSize; i *= 10)
-	{
-		++number_length;		
-		empty_field += '_';
-	}
-	empty_field += ' ';
+void Sudoku::render(std::string* grid)
+{
+	ScopedTrace trace("render");
 
-	std::string limit_line;
-	for (auto x = 0; x < mN; ++x)
-	{
-		limit_line += '+';
-		for (auto i = 0; i < (number_length + 1) * mN + 1; ++i) limit_line += '-';
-	}
-	limit_line += '+';
+	//the known numbers are collected first, the grid is then formatted from them in one go
+	get_cells(&mRender_cells);
 
-	for (auto y = 0; y < mSize; ++y)
-	{
-		if (y % mN == 0)
-		{
-			//draw limiter line
-			file << limit_line << "\n";
-		}
+	grid->clear();
+	append_sudoku_grid(mRender_cells.data(), mSize, grid);
+}
 
+void Sudoku::get_cells(std::vector<int>* cells)
+{
+	cells->resize(std::size_t(mSize) * mSize);
+	for (auto y = 0; y < mSize; ++y)
 		for (auto x = 0; x < mSize; ++x)
-		{
-			if (x % mN == 0)
-			{
-				//draw limiter char
-				file << "| ";
-			}
-
-			auto number = get_number_at_position(x, y);
-			if (number == -1) file << empty_field;
-			else {
-				number++;
-				auto n = 0;
-				for (auto i = 1; i <= number; i *= 10) ++n;
-				for (auto i = n; i < number_length; ++i) file << ' ';
-				file << number << ' ';
-				++solved_fields;
-			}
-		}
-		file << "|\n";
-	}
-	file << limit_line << std::endl;
+			(*cells)[std::size_t(y) * mSize + x] = get_number_at_position(x, y) + 1;
+}
 
-	if (mVerbose) std::cout << "Done!" << std::endl;
+std::string Sudoku::get_line()
+{
+	std::vector<int> cells;
+	get_cells(&cells);
+	return format_sudoku_line(cells, mSize);
 }
 
 int Sudoku::get_solved_fields()
@@ -1127,14 +2672,15 @@ int Sudoku::get_solved_fields()
 	return solved_fields;
 }
 
-int Sudoku::get_atom_number(const int x, const int y, const int n) const
+std::int64_t Sudoku::get_atom_number(const int x, const int y, const int n) const
 {
-	return x * mSize * mSize + y * mSize + n + 1;	//+1 so 0 is impossible
+	const std::int64_t size = mSize;
+	return x * size * size + y * size + n + 1;	//+1 so 0 is impossible
 }
 
 int Sudoku::get_luted_atom_number(const int x, const int y, const int n) const
 {
-	return mLut.at(get_atom_number(x, y, n));
+	return mAtom_index.get_atom(x, y, n);
 }
 
 int Sudoku::get_unused_atom()
@@ -1145,29 +2691,32 @@ int Sudoku::get_unused_atom()
 int Sudoku::encode_at_most_one(std::vector<int>* numbers)
 {
 	if (!ENCODE_EXTRA_COMMANDERS && numbers->size() <= 1) return 0;			//don't need to generate anything
-	if (COMMANDER_ENCODING) {
-		if (COMMANDER_ENCODING_BINARY) {
-			int commander;
-			return  commander_encode_binary(numbers, &commander);
-		} else {
-			return commander_encode(numbers);
-		}
-	} else {
+	switch (mEncoding_options.at_most_one) {
+	case AtMostOneEncoding::binary_commander: {
+		int commander;
+		return  commander_encode_binary(numbers, &commander);
+	}
+	case AtMostOneEncoding::naive:
 		return naive_encode_at_most_one(numbers);
+	default:
+		return commander_encode(numbers);
 	}
 }
 
 int Sudoku::naive_encode_at_most_one(std::vector<int>* numbers)
+{
+	return naive_encode_at_most_one(numbers->data(), numbers->size());
+}
+
+int Sudoku::naive_encode_at_most_one(const int* numbers, const std::size_t count)
 {
 	//numbers contains positive literals
 	auto generated_clauses = 0;
-	const auto numbers_amount = numbers->size();
-	for (unsigned n = 0; n < numbers_amount; ++n) {
-		for (auto m = n + 1; m < numbers_amount; ++m) {
-			std::vector<int> clause;
-			clause.push_back(-(*numbers)[n]);
-			clause.push_back(-(*numbers)[m]);
-			clause.push_back(0);
+	std::vector<int> clause(3, 0);
+	for (std::size_t n = 0; n < count; ++n) {
+		for (auto m = n + 1; m < count; ++m) {
+			clause[0] = -numbers[n];
+			clause[1] = -numbers[m];
 			write_clause(&clause);
 			++generated_clauses;
 		}
@@ -1181,6 +2730,8 @@ int Sudoku::commander_encode_binary(std::vector<int>* numbers, int* commander)
 
 	//generate a commander for this group
 	*commander = get_unused_atom();
+	if (mEncoding_options.commanders_near_groups)
+		mCommander_anchors.push_back(*std::max_element(numbers->begin(), numbers->end()));
 
 	auto size = numbers->size();
 	if (size <= mCommander_encoding_size)
@@ -1239,84 +2790,157 @@ int Sudoku::commander_encode(std::vector<int>* numbers)
 {
 	auto generated_clauses = 0;
 
-	std::vector<int> commanders;
-	auto number_count = numbers->size();
-
-	//stop case
-	if (number_count <= 1) return generated_clauses;
+	const auto number_count = int(numbers->size());
 
-	//divide into subgroups of given size
-	for (unsigned i = 0; i < number_count; i += mCommander_encoding_size) {
-		std::vector<int> subgroup;
-		for (unsigned j = i; j < i + mCommander_encoding_size && j < number_count; ++j) {
-			subgroup.push_back(numbers->at(j));
-		}
+	//amount of variables per level, taken from the template since it only depends on the group size
+	std::vector<int> computed_levels;
+	const std::vector<int>* levels = &computed_levels;
+	if (mClause_template && mClause_template->get_commander_group_size() == mCommander_encoding_size && number_count <= mSize)
+		levels = &mClause_template->get_commander_levels(number_count);
+	else
+		for (auto level = number_count; level > 1; level = (level + mCommander_encoding_size - 1) / mCommander_encoding_size)
+			computed_levels.push_back(level);
 
-		//encode subgroups naively
-		generated_clauses += naive_encode_at_most_one(&subgroup);
+	mCommander_level.assign(numbers->begin(), numbers->end());
 
-		//generate the connection from commander to group
-		auto commander = get_unused_atom();
-		commanders.push_back(commander);
-		for (unsigned j = 0; j < subgroup.size(); ++j) {
-			std::vector<int> clause;
-			clause.push_back(commander);
-			clause.push_back(-subgroup[j]);
-			clause.push_back(0);
-			write_clause(&clause);
-			++generated_clauses;
+	for (auto level_count : *levels)
+	{
+		mCommander_next_level.clear();
+
+		//divide into subgroups of given size
+		for (auto i = 0; i < level_count; i += mCommander_encoding_size) {
+			const auto subgroup = &mCommander_level[i];
+			const auto subgroup_size = std::min(mCommander_encoding_size, level_count - i);
+
+			//encode subgroups naively
+			generated_clauses += naive_encode_at_most_one(subgroup, subgroup_size);
+
+			//generate the connection from commander to group
+			auto commander = get_unused_atom();
+			mCommander_next_level.push_back(commander);
+			if (mEncoding_options.commanders_near_groups)
+				mCommander_anchors.push_back(*std::max_element(subgroup, subgroup + subgroup_size));
+			for (auto j = 0; j < subgroup_size; ++j) {
+				std::vector<int> clause;
+				clause.push_back(commander);
+				clause.push_back(-subgroup[j]);
+				clause.push_back(0);
+				write_clause(&clause);
+				++generated_clauses;
+			}
 		}
-	}
 
-	//commander encode the commanders now
-	generated_clauses += commander_encode(&commanders);
+		//commander encode the commanders now
+		mCommander_level.swap(mCommander_next_level);
+	}
 
 	return generated_clauses;
 }
 
 void Sudoku::get_position(int atom, int* x, int* y, int* n) const
 {
-	atom = mRead_lut.at(atom) - 1;
-	*n = atom % mSize;
-	atom = atom / mSize;
-	*y = atom % mSize;
-	atom = atom / mSize;
-	*x = atom;
+	mAtom_index.get_position(atom, x, y, n);
 }
 
 void Sudoku::generate_all_clauses()
 {
+	ScopedTrace trace("encode");
+
 	if (mVerbose) std::cout << "Generating clauses...\n";
 
+	mCommander_anchors.clear();
+	mVariable_numbers.clear();
+	mVariable_order.clear();
+	mEncoding_statistics.reset();
+
+	mClause_template = &ClauseTemplate::get(mSize, mCommander_encoding_size);
+
+	//the buffer is handed to the stream once, otherwise every open() allocates one
+	if (mClauses_temp_buffer.empty())
+	{
+		mClauses_temp_buffer.resize(1 << 16);
+		mClauses_temp_file.rdbuf()->pubsetbuf(mClauses_temp_buffer.data(), mClauses_temp_buffer.size());
+	}
+
 	mClauses_temp_file.open(mTemp_filename);
 	if (!mClauses_temp_file.is_open())
 	{
 		std::cerr << "Couldn't open temporary clause file \"" << mTemp_filename << "\". Exiting..." << std::endl;		
 	}
 
-	auto total_clauses = 0;
+	std::int64_t total_clauses = 0;
+
+	if (mEncoding_options.interleave_clauses)
+	{
+		total_clauses += this->add_interleaved_clauses();
+	}
+	else
+	{
+		total_clauses += this->add_single_cell_definedness_clauses();
+		total_clauses += this->add_single_cell_uniqueness_clauses();
+
+		total_clauses += this->add_row_definedness_clauses();
+		total_clauses += this->add_row_uniqueness_clauses();
+
+		total_clauses += this->add_column_definedness_clauses();
+		total_clauses += this->add_column_uniqueness_clauses();
+
+		total_clauses += this->add_section_definedness_clauses();
+		total_clauses += this->add_section_uniqueness_clauses();
+	}
+
+	mClauses_temp_file.close();
+
+	mEncoding_statistics.atoms = mNumber_of_atoms;
+	mEncoding_statistics.commander_atoms = mExtra_atom_number - 1 - mNumber_of_atoms;
+	mEncoding_statistics.pruned_atoms = mSize * mSize * mSize - mNumber_of_atoms;
+
+	if (mVerbose) std::cout << "Done!" << std::endl;
+	if (mVerbose) std::cout << "Generated a total of " << total_clauses << " clauses" << std::endl;
+}
+
+std::int64_t Sudoku::add_interleaved_clauses()
+{
+	ScopedTrace trace("add_interleaved_clauses", "clauses");
 
-	total_clauses += this->add_single_cell_definedness_clauses();
-	total_clauses += this->add_single_cell_uniqueness_clauses();
+	std::int64_t generated_clauses = 0;
 
-	total_clauses += this->add_row_definedness_clauses();
-	total_clauses += this->add_row_uniqueness_clauses();
+	//unit k is row k with its cells, column k and box k, so clauses over neighbouring atoms are emitted together
+	for (auto k = 0; k < mSize; ++k)
+	{
+		if (mVerbose) std::cout << "\rGenerating interleaved clauses... \t\t\t" << int(double(k + 1) / mSize * 100) << "% ";
 
-	total_clauses += this->add_column_definedness_clauses();
-	total_clauses += this->add_column_uniqueness_clauses();
+		for (auto x = 0; x < mSize; ++x) {
+			generated_clauses += add_single_cell_definedness_clauses(x, k);
+			generated_clauses += add_single_cell_uniqueness_clauses(x, k);
+		}
 
-	total_clauses += this->add_section_definedness_clauses();
-	total_clauses += this->add_section_uniqueness_clauses();
+		for (auto n = 0; n < mSize; ++n) {
+			generated_clauses += add_row_definedness_clauses(k, n);
+			generated_clauses += add_row_uniqueness_clauses(k, n);
+		}
 
-	mClauses_temp_file.close();
+		for (auto n = 0; n < mSize; ++n) {
+			generated_clauses += add_column_definedness_clauses(k, n);
+			generated_clauses += add_column_uniqueness_clauses(k, n);
+		}
 
-	if (mVerbose) std::cout << "Done!" << std::endl;
-	if (mVerbose) std::cout << "Generated a total of " << total_clauses << " clauses" << std::endl;
+		for (auto n = 0; n < mSize; ++n) {
+			generated_clauses += add_section_definedness_clauses(k % mN, k / mN, n);
+			generated_clauses += add_section_uniqueness_clauses(k % mN, k / mN, n);
+		}
+	}
+
+	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " interleaved clauses." << std::endl;
+	trace.set_value(generated_clauses);
+	return generated_clauses;
 }
 
-int Sudoku::add_single_cell_definedness_clauses()
+std::int64_t Sudoku::add_single_cell_definedness_clauses()
 {
-	auto generated_clauses = 0;
+	ScopedTrace trace("add_single_cell_definedness_clauses", "clauses");
+
+	std::int64_t generated_clauses = 0;
 
 	auto i = 0;
 	const auto size = mSize * mSize;
@@ -1328,27 +2952,37 @@ int Sudoku::add_single_cell_definedness_clauses()
 			if (i % percent == 0)
 				if (mVerbose) std::cout << "\rGenerating single-cell definedness clauses... \t\t" << int(double(i + 1) / size * 100) << "% ";
 
-			std::vector<int> clause;
-
-			for (auto n = 0; n < mSize; ++n) {
-				if (mSudoku_matrix[x][y][n]) clause.push_back(get_luted_atom_number(x, y, n));
-			}
-
-			clause.push_back(0);
-			write_clause(&clause);
-			++generated_clauses;
+			generated_clauses += add_single_cell_definedness_clauses(x, y);
 		}
 	}
 
 	if (mVerbose) std::cout << "\rGenerating single-cell definedness clauses... \t\t100% ";
 
 	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " single-cell definedness clauses." << std::endl;
+	trace.set_value(generated_clauses);
 	return generated_clauses;
 }
 
-int Sudoku::add_single_cell_uniqueness_clauses()
+int Sudoku::add_single_cell_definedness_clauses(const int x, const int y)
 {
-	auto generated_clauses = 0;
+	mClause_family = ClauseFamily::cell_definedness;
+
+	std::vector<int> clause;
+
+	for (auto n = 0; n < mSize; ++n) {
+		if (mSudoku_matrix.get(x, y, n)) clause.push_back(get_luted_atom_number(x, y, n));
+	}
+
+	clause.push_back(0);
+	write_clause(&clause);
+	return 1;
+}
+
+std::int64_t Sudoku::add_single_cell_uniqueness_clauses()
+{
+	ScopedTrace trace("add_single_cell_uniqueness_clauses", "clauses");
+
+	std::int64_t generated_clauses = 0;
 
 	auto i = 0;
 	const auto size = mSize * mSize;
@@ -1360,24 +2994,34 @@ int Sudoku::add_single_cell_uniqueness_clauses()
 			if (i % percent == 0)
 				if (mVerbose) std::cout << "\rGenerating single-cell uniqueness_clauses... \t\t" << int(double(i + 1) / size * 100) << "% ";
 
-			std::vector<int> possible_numbers;
-			for (auto n = 0; n < mSize; ++n) {
-				if (!mSudoku_matrix[x][y][n]) continue;
-				possible_numbers.push_back(get_luted_atom_number(x, y, n));
-			}
-
-			generated_clauses += encode_at_most_one(&possible_numbers);
+			generated_clauses += add_single_cell_uniqueness_clauses(x, y);
 		}
 	}
 
 	if (mVerbose) std::cout << "\rGenerating single-cell uniqueness_clauses... \t\t100% ";
 	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " single-cell uniqueness clauses." << std::endl;
+	trace.set_value(generated_clauses);
 	return generated_clauses;
 }
 
-int Sudoku::add_row_uniqueness_clauses()
+int Sudoku::add_single_cell_uniqueness_clauses(const int x, const int y)
 {
-	auto generated_clauses = 0;
+	mClause_family = ClauseFamily::cell_uniqueness;
+
+	std::vector<int> possible_numbers;
+	for (auto n = 0; n < mSize; ++n) {
+		if (!mSudoku_matrix.get(x, y, n)) continue;
+		possible_numbers.push_back(get_luted_atom_number(x, y, n));
+	}
+
+	return encode_at_most_one(&possible_numbers);
+}
+
+std::int64_t Sudoku::add_row_uniqueness_clauses()
+{
+	ScopedTrace trace("add_row_uniqueness_clauses", "clauses");
+
+	std::int64_t generated_clauses = 0;
 
 	auto i = 0;
 	const auto size = mSize * mSize;
@@ -1391,25 +3035,27 @@ int Sudoku::add_row_uniqueness_clauses()
 			if (i % percent == 0)
 				if (mVerbose) std::cout << "\rGenerating row uniqueness clauses... \t\t\t" << int(double(i + 1) / size * 100) << "% ";
 
-			std::vector<int> possible_numbers;
-			for (auto x = 0; x < mSize; ++x)
-			{
-				if (!mSudoku_matrix[x][y][n]) continue;
-				possible_numbers.push_back(get_luted_atom_number(x, y, n));	//collect all the positions of that number in the row
-			}
-			
-			generated_clauses += encode_at_most_one(&possible_numbers);
+			generated_clauses += add_row_uniqueness_clauses(y, n);
 		}
 	}
 
 	if (mVerbose) std::cout << "\rGenerating row uniqueness clauses... \t\t\t100% ";
 	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " row uniqueness clauses." << std::endl;
+	trace.set_value(generated_clauses);
 	return generated_clauses;
 }
 
-int Sudoku::add_row_definedness_clauses()
+int Sudoku::add_row_uniqueness_clauses(const int y, const int n)
 {
-	auto generated_clauses = 0;
+	mClause_family = ClauseFamily::row_uniqueness;
+	return add_unit_uniqueness_clauses(UnitType::row, y, n);
+}
+
+std::int64_t Sudoku::add_row_definedness_clauses()
+{
+	ScopedTrace trace("add_row_definedness_clauses", "clauses");
+
+	std::int64_t generated_clauses = 0;
 
 	auto i = 0;
 	const auto size = mSize * mSize;
@@ -1423,28 +3069,27 @@ int Sudoku::add_row_definedness_clauses()
 			if (i % percent == 0)
 				if (mVerbose) std::cout << "\rGenerating row definedness clauses... \t\t\t" << int(double(i + 1) / size * 100) << "% ";
 
-			std::vector<int> clause;
-			clause.reserve(mSize);
-			for (auto x = 0; x < mSize; ++x)
-			{
-				if (mSudoku_matrix[x][y][n]) clause.push_back(get_luted_atom_number(x, y, n));
-			}
-			if (clause.size() > 1) {	//don't add unit clauses again
-				clause.push_back(0);
-				write_clause(&clause);
-				++generated_clauses;
-			}
+			generated_clauses += add_row_definedness_clauses(y, n);
 		}
 	}
 
 	if (mVerbose) std::cout << "\rGenerating row definedness clauses... \t\t\t100% ";
 	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " row definedness clauses." << std::endl;
+	trace.set_value(generated_clauses);
 	return generated_clauses;
 }
 
-int Sudoku::add_column_uniqueness_clauses()
+int Sudoku::add_row_definedness_clauses(const int y, const int n)
 {
-	auto generated_clauses = 0;
+	mClause_family = ClauseFamily::row_definedness;
+	return add_unit_definedness_clauses(UnitType::row, y, n);
+}
+
+std::int64_t Sudoku::add_column_uniqueness_clauses()
+{
+	ScopedTrace trace("add_column_uniqueness_clauses", "clauses");
+
+	std::int64_t generated_clauses = 0;
 
 	auto i = 0;
 	const auto size = mSize * mSize;
@@ -1458,25 +3103,27 @@ int Sudoku::add_column_uniqueness_clauses()
 			if (i % percent == 0)
 				if (mVerbose) std::cout << "\rGenerating column uniqueness clauses... \t\t" << int(double(i + 1) / size * 100) << "% ";
 
-			std::vector<int> possible_numbers;
-			for (auto y = 0; y < mSize; ++y)
-			{
-				if (!mSudoku_matrix[x][y][n]) continue;
-				possible_numbers.push_back(get_luted_atom_number(x, y, n));	//collect all the positions of that number in the column
-			}
-
-			generated_clauses += encode_at_most_one(&possible_numbers);
+			generated_clauses += add_column_uniqueness_clauses(x, n);
 		}
 	}
 
 	if (mVerbose) std::cout << "\rGenerating column uniqueness clauses... \t\t100% ";
 	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " column uniqueness clauses." << std::endl;
+	trace.set_value(generated_clauses);
 	return generated_clauses;
 }
 
-int Sudoku::add_column_definedness_clauses()
+int Sudoku::add_column_uniqueness_clauses(const int x, const int n)
 {
-	auto generated_clauses = 0;
+	mClause_family = ClauseFamily::column_uniqueness;
+	return add_unit_uniqueness_clauses(UnitType::column, x, n);
+}
+
+std::int64_t Sudoku::add_column_definedness_clauses()
+{
+	ScopedTrace trace("add_column_definedness_clauses", "clauses");
+
+	std::int64_t generated_clauses = 0;
 
 	auto i = 0;
 	const auto size = mSize * mSize;
@@ -1490,28 +3137,27 @@ int Sudoku::add_column_definedness_clauses()
 			if (i % percent == 0)
 				if (mVerbose) std::cout << "\rGenerating column definedness clauses... \t\t" << int(double(i + 1) / size * 100) << "% ";
 
-			std::vector<int> clause;
-			clause.reserve(mSize);
-			for (auto y = 0; y < mSize; ++y)
-			{
-				if (mSudoku_matrix[x][y][n]) clause.push_back(get_luted_atom_number(x, y, n));
-			}
-			if (clause.size() > 1) {	//don't add unit clauses again
-				clause.push_back(0);
-				write_clause(&clause);
-				++generated_clauses;
-			}
+			generated_clauses += add_column_definedness_clauses(x, n);
 		}
 	}
 
 	if (mVerbose) std::cout << "\rGenerating column definedness clauses... \t\t100% ";
 	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " column definedness clauses." << std::endl;
+	trace.set_value(generated_clauses);
 	return generated_clauses;
 }
 
-int Sudoku::add_section_uniqueness_clauses()
+int Sudoku::add_column_definedness_clauses(const int x, const int n)
 {
-	auto generated_clauses = 0;
+	mClause_family = ClauseFamily::column_definedness;
+	return add_unit_definedness_clauses(UnitType::column, x, n);
+}
+
+std::int64_t Sudoku::add_section_uniqueness_clauses()
+{
+	ScopedTrace trace("add_section_uniqueness_clauses", "clauses");
+
+	std::int64_t generated_clauses = 0;
 
 	auto i = 0;
 	const auto size = mSize * mSize;
@@ -1523,30 +3169,29 @@ int Sudoku::add_section_uniqueness_clauses()
 				++i;
 				if (i % percent == 0)
 					if (mVerbose) std::cout << "\rGenerating section uniqueness clauses... \t\t" << int(double(i + 1) / size * 100) << "% ";
-				
-				std::vector<int> possible_numbers;
-
-				for (auto x_i = section_x * mN; x_i < (section_x + 1)*mN; ++x_i) {		//iterate through the single section
-					for (auto y_i = section_y * mN; y_i < (section_y + 1)*mN; ++y_i)
-					{
-						if (!mSudoku_matrix[x_i][y_i][n]) continue;
-						possible_numbers.push_back(get_luted_atom_number(x_i, y_i, n));
-					}
-				}
 
-				generated_clauses += encode_at_most_one(&possible_numbers);
+				generated_clauses += add_section_uniqueness_clauses(section_x, section_y, n);
 			}
 		}
 	}
 
 	if (mVerbose) std::cout << "\rGenerating section uniqueness clauses... \t\t100% ";
 	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " section uniqueness clauses." << std::endl;
+	trace.set_value(generated_clauses);
 	return generated_clauses;
 }
 
-int Sudoku::add_section_definedness_clauses()
+int Sudoku::add_section_uniqueness_clauses(const int section_x, const int section_y, const int n)
 {
-	auto generated_clauses = 0;
+	mClause_family = ClauseFamily::section_uniqueness;
+	return add_unit_uniqueness_clauses(UnitType::section, section_x * mN + section_y, n);
+}
+
+std::int64_t Sudoku::add_section_definedness_clauses()
+{
+	ScopedTrace trace("add_section_definedness_clauses", "clauses");
+
+	std::int64_t generated_clauses = 0;
 
 	auto i = 0;
 	const auto size = mSize * mSize;
@@ -1559,53 +3204,79 @@ int Sudoku::add_section_definedness_clauses()
 				if (i % percent == 0)
 					if (mVerbose) std::cout << "\rGenerating section definedness clauses... \t\t" << int(double(i + 1) / size * 100) << "% ";
 
-				std::vector<int> clause;
-
-				for (auto x_i = section_x * mN; x_i < (section_x + 1)*mN; ++x_i) {		//iterate through the single section
-					for (auto y_i = section_y * mN; y_i < (section_y + 1)*mN; ++y_i)
-					{
-						if (mSudoku_matrix[x_i][y_i][n]) clause.push_back(get_luted_atom_number(x_i, y_i, n));
-					}
-				}
-				if (clause.size() > 1) {	//don't add unit clauses again
-					clause.push_back(0);
-					write_clause(&clause);
-					++generated_clauses;
-				}
+				generated_clauses += add_section_definedness_clauses(section_x, section_y, n);
 			}
 		}
 	}
 
 	if (mVerbose) std::cout << "\rGenerating section definedness clauses... \t\t100% ";
 	if (mVerbose) std::cout << "\tGenerated " << generated_clauses << " section definedness clauses." << std::endl;
+	trace.set_value(generated_clauses);
 	return generated_clauses;
 }
 
+int Sudoku::add_section_definedness_clauses(const int section_x, const int section_y, const int n)
+{
+	mClause_family = ClauseFamily::section_definedness;
+	return add_unit_definedness_clauses(UnitType::section, section_x * mN + section_y, n);
+}
+
+int Sudoku::add_unit_uniqueness_clauses(const UnitType type, const int unit, const int n)
+{
+	const auto cells = mClause_template->get_unit_cells(type, unit);
+
+	//collect all the positions of that number in the unit
+	mUnit_literals.clear();
+	for (auto i = 0; i < mSize; ++i)
+	{
+		if (!mSudoku_matrix.get(cells[i], n)) continue;
+		mUnit_literals.push_back(get_luted_atom_number(cells[i] / mSize, cells[i] % mSize, n));
+	}
+
+	return encode_at_most_one(&mUnit_literals);
+}
+
+int Sudoku::add_unit_definedness_clauses(const UnitType type, const int unit, const int n)
+{
+	const auto cells = mClause_template->get_unit_cells(type, unit);
+
+	mUnit_literals.clear();
+	for (auto i = 0; i < mSize; ++i)
+	{
+		if (mSudoku_matrix.get(cells[i], n)) mUnit_literals.push_back(get_luted_atom_number(cells[i] / mSize, cells[i] % mSize, n));
+	}
+	if (mUnit_literals.size() > 1) {	//don't add unit clauses again
+		mUnit_literals.push_back(0);
+		write_clause(&mUnit_literals);
+		return 1;
+	}
+	return 0;
+}
+
 void Sudoku::create_lut()
 {
+	ScopedTrace trace("lut");
+
+	if (mCheckpoint_lut && mAtom_index.get_ordering() == mEncoding_options.ordering)
+	{
+		if (mVerbose) std::cout << "Using the lookup table of the checkpoint." << std::endl;
+		mExtra_atom_number = mNumber_of_atoms + 1;
+		return;
+	}
+	mCheckpoint_lut = false;
+
 	if (mVerbose) std::cout << "Creating lookup table... ";
 
-	//first entry is empty, because literals are 1-indexed
-	mRead_lut.push_back(0);
+	mAtom_index.init(mSize, mEncoding_options.ordering);
 
-	auto counter = 0;
-	for (auto y = 0; y < mSize; ++y) {
-		for (auto x = 0; x < mSize; ++x) {
-			for (auto n = 0; n < mSize; ++n) {
-				if (mSudoku_matrix[x][y][n])
-				{
-					const int atom_number = get_atom_number(x, y, n);
+	//for every atom that's not definitely negative -> entry in the LUT
+	for (auto y = 0; y < mSize; ++y)
+		for (auto x = 0; x < mSize; ++x)
+			mAtom_index.add_cell(x, y, mSudoku_matrix.get_cell(x, y));
 
-					//for every atom that's not definitely negative -> entry in the LUT
-					mLut.at(atom_number) = ++counter;
-					
-					//now fill the read_lookuptable in reverse
-					mRead_lut.push_back(atom_number);
-				}
-			}
-		}
-	}
+	mAtom_index.finalize();
 
+	const auto counter = mAtom_index.get_number_of_atoms();
 	mNumber_of_atoms = counter;
 	
 	mExtra_atom_number = mNumber_of_atoms + 1;
@@ -1614,6 +3285,109 @@ void Sudoku::create_lut()
 	if (mVerbose) std::cout << "Created " << counter << " entries in the lookup table." << std::endl;
 }
 
+bool Sudoku::write_checkpoint(const std::string& path) const
+{
+	std::uint64_t source_size, source_modified;
+	if (!get_file_stamp(mPath, &source_size, &source_modified)) return false;
+
+	CheckpointWriter checkpoint(path);
+	checkpoint.write_value(CHECKPOINT_MAGIC);
+	checkpoint.write_value(source_size);
+	checkpoint.write_value(source_modified);
+	checkpoint.write_value(mSize);
+	checkpoint.write_value(mSolvable);
+	checkpoint.write_value(std::uint64_t(std::int64_t(mUnsolvable_cell_x)));
+	checkpoint.write_value(std::uint64_t(std::int64_t(mUnsolvable_cell_y)));
+
+	mSudoku_matrix.write_checkpoint(&checkpoint);
+
+	const std::vector<std::uint8_t> fixed_cells(mFixed_cell.begin(), mFixed_cell.end());
+	checkpoint.write_array(fixed_cells);
+
+	checkpoint.write_value(mNumber_of_atoms);
+	mAtom_index.write_checkpoint(&checkpoint);
+
+	return checkpoint.finish();
+}
+
+void Sudoku::copy_preprocessed(const Sudoku& source)
+{
+	mPath = source.mPath;
+	mSudoku_matrix = source.mSudoku_matrix;
+	mFixed_cell = source.mFixed_cell;
+	mSolvable = source.mSolvable;
+	mUnsolvable_cell_x = source.mUnsolvable_cell_x;
+	mUnsolvable_cell_y = source.mUnsolvable_cell_y;
+	mCheckpoint_lut = false;
+}
+
+std::unique_ptr<Sudoku> Sudoku::resume(const std::string& sudoku_path, const std::string& checkpoint_path, const bool verbose)
+{
+	ScopedTrace trace("resume");
+	std::unique_ptr<Sudoku> sudoku;
+
+	CheckpointReader checkpoint(checkpoint_path);
+	std::uint64_t magic, source_size, source_modified, size, solvable, unsolvable_x, unsolvable_y, atoms;
+	std::uint64_t current_size, current_modified;
+	if (!checkpoint.read_value(&magic) || magic != CHECKPOINT_MAGIC
+		|| !checkpoint.read_value(&source_size) || !checkpoint.read_value(&source_modified)
+		|| !get_file_stamp(sudoku_path, &current_size, &current_modified) || source_size != current_size || source_modified != current_modified
+		|| !checkpoint.read_value(&size) || !checkpoint.read_value(&solvable)
+		|| !checkpoint.read_value(&unsolvable_x) || !checkpoint.read_value(&unsolvable_y))
+		return sudoku;
+
+	//a damaged checkpoint mustn't make the constructor allocate for an impossible size
+	const auto n = std::uint64_t(std::llround(std::sqrt(double(size))));
+	const auto is_inside = [size](const std::uint64_t cell) { return std::int64_t(cell) >= -1 && std::int64_t(cell) < std::int64_t(size); };
+	if (size == 0 || size > MAX_CHECKPOINT_SIZE || n * n != size || solvable > 1 || !is_inside(unsolvable_x) || !is_inside(unsolvable_y))
+		return sudoku;
+
+	sudoku.reset(new Sudoku(int(size), verbose));
+	sudoku->mPath = sudoku_path;
+	sudoku->mSolvable = solvable != 0;
+	sudoku->mUnsolvable_cell_x = int(std::int64_t(unsolvable_x));
+	sudoku->mUnsolvable_cell_y = int(std::int64_t(unsolvable_y));
+
+	std::size_t fixed_count;
+	const std::uint8_t* fixed_cells;
+	if (!sudoku->mSudoku_matrix.read_checkpoint(&checkpoint)
+		|| !(fixed_cells = checkpoint.read_array<std::uint8_t>(&fixed_count)) || fixed_count != sudoku->mFixed_cell.size()
+		|| !checkpoint.read_value(&atoms) || !sudoku->mAtom_index.read_checkpoint(&checkpoint, int(size))
+		|| sudoku->mAtom_index.get_number_of_atoms() != int(atoms))
+	{
+		sudoku.reset();
+		return sudoku;
+	}
+
+	//the atoms have to be exactly the candidates, a candidate without an atom would be written as the literal 0
+	std::uint64_t candidates = 0;
+	for (auto y = 0; y < sudoku->mSize; ++y)
+	{
+		for (auto x = 0; x < sudoku->mSize; ++x)
+		{
+			const auto words = sudoku->mSudoku_matrix.get_cell(x, y);
+			for (auto w = 0; w < sudoku->mSudoku_matrix.get_words_per_cell(); ++w) candidates += __builtin_popcountll(words[w]);
+			if (!sudoku->mAtom_index.contains_cell(x, y, words))
+			{
+				sudoku.reset();
+				return sudoku;
+			}
+		}
+	}
+	if (candidates != atoms)
+	{
+		sudoku.reset();
+		return sudoku;
+	}
+
+	std::copy(fixed_cells, fixed_cells + fixed_count, sudoku->mFixed_cell.begin());
+	sudoku->mNumber_of_atoms = int(atoms);
+	sudoku->mCheckpoint_lut = true;
+
+	if (verbose) std::cout << "Resumed the preprocessed Sudoku from \"" << checkpoint_path << "\"." << std::endl;
+	return sudoku;
+}
+
 //currently unneeded
 void Sudoku::read_lut(const std::string& path)
 {
@@ -1636,20 +3410,22 @@ void Sudoku::read_lut(const std::string& path)
 	ss << content;
 	ss >> mNumber_of_atoms;		//second number is number of atoms
 
-	mRead_lut.resize(mNumber_of_atoms+1, 0);
+	mAtom_index.init(mSize);
 
-	while (!file.eof()) {
+	while (std::getline(file, content)) {
 		ss.str("");
 		ss.clear();
-		std::getline(file, content);
 		ss << content;
-		ss >> i;
-		ss >> j;
-		
-		mRead_lut.at(i) = j;
+		if (!(ss >> i >> j)) continue;
+
+		//j is the uncompressed atom number, i follows from the order of the index
+		--j;
+		mAtom_index.add(j / (mSize * mSize), j / mSize % mSize, j % mSize);
 		++counter;
 	}
 
+	mAtom_index.finalize();
+
 	if (mVerbose) std::cout << "Done." << std::endl;
 	if (mVerbose) std::cout << "Read " << counter << " entries in the lookup table." << std::endl;
 }
@@ -1665,20 +3441,57 @@ void Sudoku::write_lut(const std::string& path) const
 	file << mSize << "\n";
 	file << mNumber_of_atoms << "\n";
 
-	const auto cube = mSize * mSize * mSize;
-	const auto square = mSize * mSize;
+	const auto percent = (mNumber_of_atoms >= 100) ? mNumber_of_atoms / 100 : 1;
 
-	for (auto i = 0; i < cube; ++i)
+	for (auto atom = 1; atom <= mNumber_of_atoms; ++atom)
 	{
-		if (i % square == 0)
-			if (mVerbose) std::cout << "\rWriting lookup table to file... \t\t\t" << int(double(i+1) / cube * 100) << "% ";
-		if (mLut.at(i) != 0)
-			file << mLut.at(i) << " " << i << "\n";
+		if (atom % percent == 0)
+			if (mVerbose) std::cout << "\rWriting lookup table to file... \t\t\t" << int(double(atom) / mNumber_of_atoms * 100) << "% ";
+		int x, y, n;
+		mAtom_index.get_position(atom, &x, &y, &n);
+		file << atom << " " << get_atom_number(x, y, n) << "\n";
 	}
 
 	if (mVerbose) std::cout << "\rWriting lookup table to file... \t\t\t100% " << std::endl;
 }
 
+void Sudoku::create_variable_order()
+{
+	const auto variables = mExtra_atom_number - 1;
+
+	//the commanders placed behind every variable, in the order they were created
+	std::vector<int> first_child(variables + 2, 0);
+	for (auto anchor : mCommander_anchors) ++first_child[anchor + 1];
+	for (auto v = 1; v <= variables + 1; ++v) first_child[v] += first_child[v - 1];
+
+	std::vector<int> children(mCommander_anchors.size());
+	std::vector<int> next_child(first_child.begin(), first_child.end() - 1);
+	for (unsigned i = 0; i < mCommander_anchors.size(); ++i)
+		children[next_child[mCommander_anchors[i]]++] = mNumber_of_atoms + 1 + i;
+
+	//depth first, so a commander directly follows its group and the commanders of that group
+	mVariable_order.assign(1, 0);
+	mVariable_order.reserve(variables + 1);
+	mVariable_numbers.assign(variables + 1, 0);
+
+	std::vector<int> stack;
+	for (auto atom = 1; atom <= mNumber_of_atoms; ++atom)
+	{
+		stack.push_back(atom);
+		while (!stack.empty())
+		{
+			const auto variable = stack.back();
+			stack.pop_back();
+
+			mVariable_numbers[variable] = mVariable_order.size();
+			mVariable_order.push_back(variable);
+
+			for (auto child = first_child[variable + 1] - 1; child >= first_child[variable]; --child)
+				stack.push_back(children[child]);
+		}
+	}
+}
+
 void Sudoku::write_clause(std::vector<int>* clause)
 {
 	for (auto lit : *clause)
@@ -1687,10 +3500,13 @@ void Sudoku::write_clause(std::vector<int>* clause)
 	}
 	mClauses_temp_file << "\n";
 	++mNumber_of_clauses;
+	mEncoding_statistics.add_clause(mClause_family, clause->size() - 1);
 }
 
 void Sudoku::write_clauses()
 {
+	ScopedTrace trace("write");
+
 	//close temp file in case it's still open
 	if (mClauses_temp_file.is_open())
 		mClauses_temp_file.close();
@@ -1700,16 +3516,34 @@ void Sudoku::write_clauses()
 	std::ofstream output_file(mClauses_output_filename);
 	output_file << "p cnf " << mExtra_atom_number - 1 << " " << mNumber_of_clauses << "\n";
 
-	//copy contents of temp file
-	output_file << in_file.rdbuf();
+	if (!mCommander_anchors.empty())
+	{
+		//copy contents of temp file, renumbering every literal
+		create_variable_order();
+
+		int lit;
+		while (in_file >> lit)
+		{
+			if (lit == 0) output_file << "0 \n";
+			else output_file << (lit > 0 ? mVariable_numbers[lit] : -mVariable_numbers[-lit]) << " ";
+		}
+	}
+	else
+	{
+		//copy contents of temp file
+		output_file << in_file.rdbuf();
+	}
 
+	mEncoding_statistics.dimacs_bytes = output_file.tellp();
 	output_file.close();
 
 	std::remove(mTemp_filename.c_str());
 }
 
-void Sudoku::read_solution(const std::string& path)
+void Sudoku::read_solution(const std::string& path, const ModelFormat format)
 {
+	ScopedTrace trace("decode");
+
 	if (mVerbose) std::cout << "Reading solution at \"" << path << "\"... ";
 
 	std::ifstream file(path);
@@ -1723,13 +3557,21 @@ void Sudoku::read_solution(const std::string& path)
 		ss.str("");
 		ss.clear();
 		ss << content;
-		ss >> line_type;
+
+		//minisat style models have the literals on lines of their own
+		if (format == ModelFormat::minisat && (std::isdigit(content[0]) || content[0] == '-')) line_type = 'v';
+		else ss >> line_type;
+
 		if (line_type == 'v')
 		{
 			int lit;
 			//the lines with the literals that we're looking for
 			while (ss >> lit)
 			{
+				//translate back if the variables were renumbered
+				if (lit > 0 && !mVariable_order.empty())
+					lit = lit < int(mVariable_order.size()) ? mVariable_order[lit] : 0;
+
 				//only need to read positive and relevant literals
 				if (lit > 0 && lit <= mNumber_of_atoms)
 				{
@@ -1744,6 +3586,128 @@ void Sudoku::read_solution(const std::string& path)
 	if (mVerbose) std::cout << "Done!" << std::endl;
 }
 
+std::vector<std::vector<int>> Sudoku::generate_cubes(const int max_cubes)
+{
+	ScopedTrace trace("cubes");
+
+	//lookahead over the open cells, the ones with the fewest numbers left split the search space best
+	std::vector<std::pair<int, int>> open_cells;
+	for (auto x = 0; x < mSize; ++x) {
+		for (auto y = 0; y < mSize; ++y) {
+			const auto count = mSudoku_matrix.count(x, y);
+			if (count > 1) open_cells.push_back({count, x * mSize + y});
+		}
+	}
+
+	std::sort(open_cells.begin(), open_cells.end());
+
+	//take cells as long as the product of their candidates stays within max_cubes
+	std::vector<int> split_cells;
+	std::int64_t product = 1;
+	for (const auto& cell : open_cells)
+	{
+		if (product * cell.first > max_cubes) break;
+		product *= cell.first;
+		split_cells.push_back(cell.second);
+	}
+
+	std::vector<std::vector<int>> cubes;
+	if (split_cells.empty()) return cubes;
+
+	//enumerate the assignments of the split cells, leaving out the ones where two cells of a unit get the same number
+	std::vector<int> numbers(split_cells.size(), -1);
+	auto depth = 0;
+	while (depth >= 0)
+	{
+		const auto x = split_cells[depth] / mSize;
+		const auto y = split_cells[depth] % mSize;
+
+		//next possible number for this cell
+		auto& number = numbers[depth];
+		for (++number; number < mSize; ++number)
+		{
+			if (!mSudoku_matrix.get(x, y, number)) continue;
+
+			auto conflict = false;
+			for (auto i = 0; i < depth && !conflict; ++i)
+			{
+				const auto x_i = split_cells[i] / mSize;
+				const auto y_i = split_cells[i] % mSize;
+				const auto same_unit = x_i == x || y_i == y || (x_i / mN == x / mN && y_i / mN == y / mN);
+				conflict = same_unit && numbers[i] == number;
+			}
+			if (!conflict) break;
+		}
+
+		if (number == mSize)
+		{
+			//no number left, go back
+			number = -1;
+			--depth;
+			continue;
+		}
+
+		if (depth + 1 < int(split_cells.size()))
+		{
+			++depth;
+			continue;
+		}
+
+		std::vector<int> cube;
+		for (unsigned i = 0; i < split_cells.size(); ++i)
+			cube.push_back(get_luted_atom_number(split_cells[i] / mSize, split_cells[i] % mSize, numbers[i]));
+		cubes.push_back(cube);
+	}
+
+	return cubes;
+}
+
+void Sudoku::write_cube_clauses(const std::string& path, const std::vector<int>& cube) const
+{
+	std::ifstream in_file(mClauses_output_filename);
+
+	//skip the header, the cube adds one unit clause per literal
+	std::string header;
+	std::getline(in_file, header);
+
+	std::ofstream output_file(path);
+	output_file << "p cnf " << mExtra_atom_number - 1 << " " << mNumber_of_clauses + std::int64_t(cube.size()) << "\n";
+	output_file << in_file.rdbuf();
+
+	for (auto lit : cube)
+	{
+		if (!mVariable_numbers.empty()) lit = mVariable_numbers[lit];
+		output_file << lit << " 0 \n";
+	}
+}
+
+void Sudoku::set_encoding_options(const EncodingOptions& options)
+{
+	mEncoding_options = options;
+
+	if (options.commander_size > 1)
+		mCommander_encoding_size = options.commander_size;
+
+	if (mVerbose && options.at_most_one != AtMostOneEncoding::naive)
+		std::cout << "Using commander encoding with max group size " << mCommander_encoding_size << "." << std::endl;
+}
+
+void Sudoku::set_scratch_prefix(const std::string& prefix)
+{
+	set_scratch_files(prefix + "temp_clauses.txt", prefix + "clauses_out.cnf");
+}
+
+void Sudoku::set_scratch_files(const std::string& temp_path, const std::string& clauses_path)
+{
+	mTemp_filename = temp_path;
+	mClauses_output_filename = clauses_path;
+}
+
+const std::string& Sudoku::get_clauses_filename() const
+{
+	return mClauses_output_filename;
+}
+
 int Sudoku::get_size() const
 {
 	return mSize;
@@ -1764,11 +3728,33 @@ int Sudoku::get_ce_size() const
 	return mCommander_encoding_size;
 }
 
-int Sudoku::get_number_of_clauses() const
+std::int64_t Sudoku::get_number_of_clauses() const
 {
 	return mNumber_of_clauses;
 }
 
+const EncodingStatistics& Sudoku::get_encoding_statistics() const
+{
+	return mEncoding_statistics;
+}
+
+MemoryUsage Sudoku::get_memory_usage() const
+{
+	const auto int_bytes = [](const std::vector<int>& buffer) { return buffer.capacity() * sizeof(int); };
+
+	MemoryUsage usage;
+	usage.candidates = mSudoku_matrix.get_bytes();
+	usage.fixed_cells = (mFixed_cell.capacity() + 7) / 8;
+	usage.lookup = mAtom_index.get_lookup_bytes();
+	usage.reverse_lookup = mAtom_index.get_reverse_bytes();
+	usage.clause_buffers = (mClause_template ? mClause_template->get_bytes() : 0) + int_bytes(mUnit_literals) + int_bytes(mCommander_level)
+						 + int_bytes(mCommander_next_level) + int_bytes(mCommander_anchors) + int_bytes(mVariable_numbers)
+						 + int_bytes(mVariable_order);
+	usage.preprocessing_buffers = int_bytes(mFound_cells) + int_bytes(mOccurrences_x) + int_bytes(mOccurrences_y);
+	usage.io_buffers = mClauses_temp_buffer.capacity() + int_bytes(mRender_cells);
+	return usage;
+}
+
 void Sudoku::get_unsolvable_cell(int* x, int* y) const
 {
 	*x = mUnsolvable_cell_x;
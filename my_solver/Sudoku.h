@@ -2,17 +2,118 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <cstdint>
+#include <memory>
+#include <sys/resource.h>
+#include "AtomIndex.h"
+#include "CandidateMatrix.h"
+#include "EncodingStatistics.h"
+#include "ClauseTemplate.h"
+#include "SolverSupervisor.h"
+#include "ScratchFile.h"
+#include "SolverAdapter.h"
+#include "SolutionCache.h"
+#include "SudokuParser.h"
+#include "PhaseBenchmark.h"
+
+//how the "at most one"-clauses are encoded
+enum class AtMostOneEncoding
+{
+	commander,				//commander encoding with groups of the commander size
+	binary_commander,		//commander encoding as a binary tree
+	naive					//one clause per pair
+};
+
+//options for how the cnf is laid out and encoded
+struct EncodingOptions
+{
+	AtomOrdering ordering = AtomOrdering::cell_major;
+	bool interleave_clauses = false;			//emit the clauses unit by unit instead of family by family
+	bool commanders_near_groups = false;		//number every commander right after the last variable of its group
+	AtMostOneEncoding at_most_one = AtMostOneEncoding::commander;
+	int commander_size = 0;						//group size of the commander encoding, 0 uses the measured size for the order
+};
+
+//options for solving with several solver processes
+struct ParallelOptions
+{
+	int cubes = 0;			//cube and conquer: split into about this many cubes, 0 or 1 disables it
+	int jobs = 0;			//solvers running at the same time, 0 uses one per core
+	bool cube_speedup = false;	//cube and conquer: also solve the whole cnf with a single solver to measure the speedup
+	bool pipeline = false;	//batch: overlap parsing, preprocessing and encoding with the solvers instead of solving whole sudokus per thread
+	int queue_size = 2;		//pipeline: sudokus that can wait between two stages
+	SolverLimits limits;	//wall and cpu time limit of every solver run
+	bool memory_scratch = false;	//keep the cnf and model files in memory instead of the working directory, see ScratchFile
+};
+
+//what solving can take over from earlier runs
+struct ReuseOptions
+{
+	SolutionCache* cache = nullptr;			//solutions of equivalent sudokus, see SolutionCache
+	std::string checkpoint_directory;		//preprocessed sudokus with their lookup table, see Sudoku::write_checkpoint()
+};
+
+//options of the phase benchmark, see bench_sudokus()
+struct BenchOptions
+{
+	std::string solver;			//without a solver only the phases up to write and the render are timed
+	int repeats = 5;			//timed runs of every sudoku
+	int warmup = 1;				//runs before them that aren't recorded
+	double threshold = 0.1;		//compare: a phase more than this much slower than the baseline is a regression
+	double min_seconds = 1e-4;	//compare: phases shorter than this in the baseline are too noisy to judge
+};
+
+//bytes held by the structures of a sudoku, see Sudoku::get_memory_usage()
+struct MemoryUsage
+{
+	std::size_t candidates = 0;				//the candidate matrix
+	std::size_t fixed_cells = 0;
+	std::size_t lookup = 0;					//candidate -> atom, the lut
+	std::size_t reverse_lookup = 0;			//atom -> candidate, what reading the solution needs
+	std::size_t clause_buffers = 0;			//the clause template of the size and the buffers of the clause generation
+	std::size_t preprocessing_buffers = 0;
+	std::size_t io_buffers = 0;				//the buffer of the temporary clause file and the one of render()
+
+	std::size_t get_total() const
+	{
+		return candidates + fixed_cells + lookup + reverse_lookup + clause_buffers + preprocessing_buffers + io_buffers;
+	}
+};
+
+//everything a row of the benchmark csv needs besides the sudoku itself
+struct BenchmarkRow
+{
+	std::string path;
+	double seconds = 0;
+	double solver_seconds = 0;
+	long solver_max_rss = 0;		//in KB
+	int cubes = 1;
+	int jobs = 1;
+	double solver_cpu_seconds = 0;
+	std::string solver;
+};
 
 class Sudoku
 {
 public:
 	explicit Sudoku(std::string path, bool verbose);
 	Sudoku(const std::string& solution_path, const std::string& lut_path);
+
+	//an empty sudoku of the given size that is filled with load(), so one object can solve many sudokus of that size
+	Sudoku(int size, bool verbose);
 	~Sudoku();
 
-	void init_size();
+	//forgets the sudoku, every cell can hold every number again, all buffers keep their memory
+	void reset();
+
+	//reset() and then sets the given cells, row by row with 0 for an empty cell
+	//the size has to match, returns false if a number doesn't fit
+	//a reused sudoku doesn't allocate here nor in the preprocessing and create_lut()
+	bool load(const std::vector<int>& cells);
+
+	//maps the file at mPath and parses size and cells in one pass, false if it isn't a sudoku
+	bool read_file(std::vector<int>* cells);
 	void init_matrix();
-	void read_sudoku();
 
 	//sets a field and applies its consequences all over the sudoku
 	bool set_field(int row_x, int row_y, int number);
@@ -37,90 +138,179 @@ public:
 	void print();
 	void print_out(std::string path);
 
+	//formats the current sudoku like print() into the buffer
+	void render(std::string* grid);
+
+	//the cells row by row, 0 for a cell that isn't known yet
+	void get_cells(std::vector<int>* cells);
+
+	//the cells row by row in the format of parse_sudoku_line()
+	std::string get_line();
+
 	//returns the number of known numbers in the sudoku
 	//also detects potential insolubility
 	int get_solved_fields();
 
 	//clause generator helper functions
-	int get_atom_number(int x, int y, int n) const;
+	std::int64_t get_atom_number(int x, int y, int n) const;
 	int get_luted_atom_number(int x, int y, int n) const;
 	int get_unused_atom();
 
 	//at-most-one-encoding helper functions, they return the number of clauses they created
 	int encode_at_most_one(std::vector<int>* numbers);
 	int naive_encode_at_most_one(std::vector<int>* numbers);	
+	int naive_encode_at_most_one(const int* numbers, std::size_t count);
 	int commander_encode_binary(std::vector<int>* numbers, int* commander);
 	int commander_encode(std::vector<int>* numbers);
 
 	//reverse clause generator helper functions
 	void get_position(int atom, int* x, int* y, int* n) const;
 
+	//has to be set before create_lut()
+	void set_encoding_options(const EncodingOptions& options);
+
+	//puts the temporary and the finished cnf file behind the prefix, so several encodings can exist at once
+	void set_scratch_prefix(const std::string& prefix);
+	void set_scratch_files(const std::string& temp_path, const std::string& clauses_path);
+	const std::string& get_clauses_filename() const;
+
 	//calls all the other clause generating functions
 	void generate_all_clauses();
 
 	//clause functions, add clauses
-	int add_single_cell_definedness_clauses();			//generates definedness constraints for cells
-	int add_single_cell_uniqueness_clauses();			//generates uniqueness constraints for cells
+	std::int64_t add_single_cell_definedness_clauses();			//generates definedness constraints for cells
+	std::int64_t add_single_cell_uniqueness_clauses();			//generates uniqueness constraints for cells
+
+	std::int64_t add_row_definedness_clauses();					//generates definedness constraints for the rows
+	std::int64_t add_row_uniqueness_clauses();					//generates uniqueness constraints for the rows
+
+	std::int64_t add_column_definedness_clauses();				//generates definedness constraints for the columns
+	std::int64_t add_column_uniqueness_clauses();				//generates uniqueness constraints for the columns
 
-	int add_row_definedness_clauses();					//generates definedness constraints for the rows
-	int add_row_uniqueness_clauses();					//generates uniqueness constraints for the rows
+	std::int64_t add_section_definedness_clauses();				//generates definedness constraints for the sections
+	std::int64_t add_section_uniqueness_clauses();				//generates uniqueness constraints for the sections
 
-	int add_column_definedness_clauses();				//generates definedness constraints for the columns
-	int add_column_uniqueness_clauses();				//generates uniqueness constraints for the columns
+	std::int64_t add_interleaved_clauses();						//generates all of the above, unit by unit
 
-	int add_section_definedness_clauses();				//generates definedness constraints for the sections
-	int add_section_uniqueness_clauses();				//generates uniqueness constraints for the sections
+	//the same constraints for a single unit, the row/column/section ones go through the clause template
+	int add_unit_definedness_clauses(UnitType type, int unit, int n);
+	int add_unit_uniqueness_clauses(UnitType type, int unit, int n);
+	int add_single_cell_definedness_clauses(int x, int y);
+	int add_single_cell_uniqueness_clauses(int x, int y);
+	int add_row_definedness_clauses(int y, int n);
+	int add_row_uniqueness_clauses(int y, int n);
+	int add_column_definedness_clauses(int x, int n);
+	int add_column_uniqueness_clauses(int x, int n);
+	int add_section_definedness_clauses(int section_x, int section_y, int n);
+	int add_section_uniqueness_clauses(int section_x, int section_y, int n);
+
+	//a binary snapshot of the preprocessed sudoku and its lookup table, together with the size and modification time of the
+	//sudoku file, so a later run maps it instead of reading and preprocessing again
+	//has to be called after create_lut()
+	bool write_checkpoint(const std::string& path) const;
+
+	//the sudoku at sudoku_path as the checkpoint left it, nullptr if there is none or the sudoku changed since
+	//the next create_lut() takes the lookup table from the checkpoint if the ordering is the same
+	static std::unique_ptr<Sudoku> resume(const std::string& sudoku_path, const std::string& checkpoint_path, bool verbose);
+
+	//takes over the candidates and fixed cells of a preprocessed sudoku of the same size, so several encodings of it
+	//don't have to preprocess again, the lookup table is left to create_lut()
+	void copy_preprocessed(const Sudoku& source);
 
 	//functions for the lookup table
 	void create_lut();
 	void read_lut(const std::string& path);
 	void write_lut(const std::string& path) const;
 
+	//numbers the commanders right after their groups, see EncodingOptions::commanders_near_groups
+	void create_variable_order();
+
+	//cube and conquer: splits on the open cells with the fewest candidates
+	//returns at most max_cubes cubes, every cube is a list of atoms that are set to true
+	std::vector<std::vector<int>> generate_cubes(int max_cubes);
+
+	//writes the cnf written by write_clauses() together with the unit clauses of the cube
+	void write_cube_clauses(const std::string& path, const std::vector<int>& cube) const;
+
 	//writes the clauses out to a file
 	void write_clause(std::vector<int>* clause);
 	void write_clauses();
 
 	//reads the output of the sat solver and shows the finished sudoku
-	void read_solution(const std::string& path);
+	void read_solution(const std::string& path, ModelFormat format = ModelFormat::competition);
 
 	int get_size() const;
 	int get_n() const;
 	bool is_solvable() const;
 	int get_ce_size() const;
-	int get_number_of_clauses() const;
+	std::int64_t get_number_of_clauses() const;
+
+	//the clauses, literals and atoms of the last generate_all_clauses() and the bytes of the last write_clauses()
+	const EncodingStatistics& get_encoding_statistics() const;
+
+	//what the sudoku holds right now, without the memory the allocator or the streams keep on their own
+	MemoryUsage get_memory_usage() const;
 
 	void get_unsolvable_cell(int* x, int* y) const;
 
 private:
 	
-	std::vector<std::vector<std::vector<bool>>> mSudoku_matrix;	//saves which numbers are possible for each field in the sudoku
-	std::vector<std::vector<bool>> mFixed_cell;
+	CandidateMatrix mSudoku_matrix;								//saves which numbers are possible for each field in the sudoku
+	std::vector<bool> mFixed_cell;								//one entry per cell, index x * mSize + y
 	int mSize{};												//the size, for a 3-sudoku this will be 9, etc.
 	int mN{};													//the n of the sudoku, 3-sudoku -> 3
 	std::string mPath;											//path to the sudoku
 
-	//temp file for writing clauses initially
+	//temp file for writing clauses initially, it writes through mClauses_temp_buffer which outlives every open()
 	std::ofstream mClauses_temp_file;
 	std::string mTemp_filename;
+	std::vector<char> mClauses_temp_buffer;
 
 	//output file for the finished cnf file
 	std::string mClauses_output_filename;
 
-	int mNumber_of_clauses = 0;
+	std::int64_t mNumber_of_clauses = 0;
+
+	//write_clause() counts every clause for the family whose clauses are being generated
+	EncodingStatistics mEncoding_statistics;
+	ClauseFamily mClause_family = ClauseFamily::cell_definedness;
 
 	int mCommander_encoding_size = 0;
 
 	//lookup table for compressing number of atoms without losing reconstructability
-	//this is an array -> at index of atom is its actual counterpart number
-	std::vector<int> mLut;
-
-	//the lut stored in reverse, when reading in a solution
-	std::vector<int> mRead_lut;
+	//maps every candidate that's still possible to its atom number and back
+	AtomIndex mAtom_index;
 
 	int mNumber_of_atoms{};
 	int mExtra_atom_number;		//used for the extra atoms for the commander encoding
 
+	EncodingOptions mEncoding_options;
+
+	//shared structure of the clauses for this size, set when generating the clauses
+	const ClauseTemplate* mClause_template = nullptr;
+
+	//buffers reused by the clause generation
+	std::vector<int> mUnit_literals;
+	std::vector<int> mCommander_level;
+	std::vector<int> mCommander_next_level;
+
+	//buffers reused by the preprocessing
+	std::vector<int> mFound_cells;
+	std::vector<int> mOccurrences_x;
+	std::vector<int> mOccurrences_y;
+
+	//the known numbers render() formats the grid from
+	std::vector<int> mRender_cells;
+
+	//for every commander the variable of its group it is placed behind, only filled if commanders_near_groups is set
+	std::vector<int> mCommander_anchors;
+
+	//if the variables are renumbered when writing the cnf: old number -> new number and the reverse
+	std::vector<int> mVariable_numbers;
+	std::vector<int> mVariable_order;
+
 	bool mSolvable = true;
+	bool mCheckpoint_lut = false;		//mAtom_index was read from a checkpoint and create_lut() may keep it
 
 	int mUnsolvable_cell_x = -1;
 	int mUnsolvable_cell_y = -1;
@@ -134,8 +324,48 @@ struct x_wing_type {
 	int pos3;
 };
 
-void benchmark_sudokus(std::string path, std::string solver, std::string output_path);
-void solve_sudoku(std::string path, std::string solver, std::string outputfile = "", bool verbose = false, bool omit_output = false);
-int system_call(std::string command);
+void benchmark_sudokus(std::string path, const std::vector<std::string>& solvers, std::string output_path, const EncodingOptions& encoding_options = EncodingOptions(),
+					   const ParallelOptions& parallel_options = ParallelOptions(), const ReuseOptions& reuse = ReuseOptions());
+void print_solver_comparison(const std::string& benchmark_path);
+void benchmark_setup(const std::string& path, int count);
+void bench_sudokus(const std::vector<std::string>& paths, const std::string& output_path, const BenchOptions& bench_options,
+				   const EncodingOptions& encoding_options = EncodingOptions(), const ParallelOptions& parallel_options = ParallelOptions());
+void benchmark_parser(const std::vector<std::string>& paths, int count);
+std::string get_checkpoint_path(const std::string& directory, const std::string& sudoku_path);
+void generate_sudokus(int n, int count, const std::string& folder, double given_ratio);
+int get_commander_encoding_size(int n);
+void solve_sudoku(std::string path, std::string solver, std::string outputfile = "", bool verbose = false, bool omit_output = false,
+				  const EncodingOptions& encoding_options = EncodingOptions(), const ParallelOptions& parallel_options = ParallelOptions(),
+				  const std::string& scratch_prefix = "", const ReuseOptions& reuse = ReuseOptions());
+void write_benchmark_header(const std::string& outputfile);
+void append_benchmark_row(const std::string& outputfile, Sudoku* sudoku, const BenchmarkRow& row, const EncodingOptions& encoding_options);
+std::vector<std::string> collect_sudoku_files(const std::vector<std::string>& paths);
+void pipeline_sudokus(const std::vector<std::string>& files, const std::string& solver, const std::string& output_path,
+					  const EncodingOptions& encoding_options, int jobs, const ParallelOptions& parallel_options, const ReuseOptions& reuse = ReuseOptions());
+void batch_sudokus(const std::vector<std::string>& paths, const std::string& solver, const std::string& output_path,
+				   const EncodingOptions& encoding_options, const ParallelOptions& parallel_options, const ReuseOptions& reuse = ReuseOptions());
+void solve_corpus(const std::vector<std::string>& paths, const std::string& solver, const std::string& output_path,
+				  const EncodingOptions& encoding_options, const ParallelOptions& parallel_options, const ReuseOptions& reuse = ReuseOptions());
+bool pack_corpus(const std::vector<std::string>& paths, const std::string& output_path);
+void validate_sudokus(const std::string& task_path, const std::string& output_path, const std::string& verdict_path, int jobs, bool check_consistency);
+void solve_portfolio(const std::string& path, const std::string& solver, const std::vector<EncodingOptions>& variants,
+					 int jobs, const ParallelOptions& parallel_options, bool verbose, bool omit_output);
+bool parse_portfolio_variant(const std::string& variant, EncodingOptions* options);
+std::string get_encoding_name(const EncodingOptions& options);
+int system_call(std::string command, struct rusage* usage = nullptr);
+std::string get_scratch_path(const std::string& name, bool in_memory, std::vector<ScratchFile>* files);
+std::string get_process_prefix(const std::string& name);
+std::string get_job_prefix(int job);
+pid_t fork_command_process();
+pid_t start_command(const std::string& command);
+int finish_command(pid_t pid, struct rusage* usage);
+int run_solvers_until_answer(const SolverAdapter& adapter, const std::vector<std::string>& cnf_paths, const std::vector<std::string>& model_paths,
+							 int jobs, bool stop_on_unsatisfiable, int* answer, struct rusage* usage, double* cpu_seconds,
+							 const SolverLimits& limits = SolverLimits(), bool verbose = false);
+bool check_solver(const std::string& solver);
+void track_command(pid_t pid);
+void untrack_command(pid_t pid);
+double get_cpu_seconds(const struct rusage& usage);
+long get_own_max_rss();
 
 void signal_handler(int signum);
@@ -0,0 +1,341 @@
+#include "pch.h"
+#include "SudokuParser.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const int HEADER_LINES = 4;
+const int READER_HEADER_LINES = 2;
+const int READER_SIZE = 9;			//the sudoku reader only reads 3-sudokus
+const int MAX_COMPACT_SIZE = 35;	//1-9 and A-Z
+
+static const char* skip_line(const char* position, const char* end)
+{
+	const auto newline = static_cast<const char*>(std::memchr(position, '\n', std::size_t(end - position)));
+	return newline ? newline + 1 : end;
+}
+
+static const char* find_line_end(const char* position, const char* end)
+{
+	const auto newline = static_cast<const char*>(std::memchr(position, '\n', std::size_t(end - position)));
+	return newline ? newline : end;
+}
+
+static bool is_separator(const char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '|';
+}
+
+static bool is_digit(const char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+//a row holds cells if it has anything but blanks and doesn't start with the + of a delimiter line
+static bool is_row(const char* position, const char* line_end)
+{
+	while (position < line_end && (*position == ' ' || *position == '\t' || *position == '\r')) ++position;
+	return position < line_end && *position != '+';
+}
+
+//scans the cells of one row, the first capacity of them are stored, returns how many there are or -1 for an unknown token
+static int scan_row(const char* position, const char* line_end, int* cells, const int capacity)
+{
+	auto count = 0;
+	while (position < line_end)
+	{
+		if (is_separator(*position))
+		{
+			++position;
+			continue;
+		}
+
+		auto number = 0;
+		if (is_digit(*position))
+		{
+			do
+			{
+				number = number * 10 + (*position++ - '0');
+				if (number > 1 << 24) return -1;
+			} while (position < line_end && is_digit(*position));
+		}
+		else if (*position == '_' || *position == '.')
+		{
+			do ++position; while (position < line_end && (*position == '_' || *position == '.'));
+		}
+		else return -1;
+
+		//a token ends at a separator, "12_" is none
+		if (position < line_end && !is_separator(*position)) return -1;
+
+		if (count < capacity) cells[count] = number;
+		++count;
+	}
+	return count;
+}
+
+//the size in the last header line, the first number in front of the x of "puzzle size: 25x25"
+static int scan_header_size(const char* position, const char* line_end)
+{
+	const auto x = static_cast<const char*>(std::memchr(position, 'x', std::size_t(line_end - position)));
+	if (!x) return -1;
+
+	for (auto token_start = true; position < x; ++position)
+	{
+		if (token_start && is_digit(*position))
+		{
+			auto size = 0;
+			while (position < x && is_digit(*position) && size <= 1 << 16) size = size * 10 + (*position++ - '0');
+			return size;
+		}
+		token_start = *position == ' ' || *position == '\t';
+	}
+	return -1;
+}
+
+bool read_sudoku_file(const std::string& path, std::vector<int>* cells, int* size)
+{
+	const MappedFile file(path);
+	if (!file.is_open()) return false;
+
+	return parse_sudoku_text(file.data(), file.data() + file.size(), cells, size);
+}
+
+bool parse_sudoku_text(const char* begin, const char* end, std::vector<int>* cells, int* size)
+{
+	if (begin == end) return false;
+
+	static const char experiment[] = "experiment:";
+	const auto experiment_length = sizeof(experiment) - 1;
+
+	auto position = begin;
+	if (std::size_t(end - begin) >= experiment_length && std::memcmp(begin, experiment, experiment_length) == 0)
+	{
+		for (auto i = 0; i < HEADER_LINES - 1; ++i) position = skip_line(position, end);
+
+		const auto line_end = find_line_end(position, end);
+		*size = scan_header_size(position, line_end);
+		position = skip_line(line_end, end);
+	}
+	else if (*begin == '+')
+	{
+		//the first row tells the size
+		auto row = begin;
+		while (row < end && !is_row(row, find_line_end(row, end))) row = skip_line(row, end);
+		*size = scan_row(row, find_line_end(row, end), nullptr, 0);
+	}
+	else
+	{
+		for (auto i = 0; i < READER_HEADER_LINES; ++i) position = skip_line(position, end);
+		*size = READER_SIZE;
+	}
+
+	//every cell takes at least a character and a separator, which also keeps absurd sizes out
+	const auto n = int(std::lround(std::sqrt(std::max(*size, 0))));
+	if (*size <= 0 || n * n != *size || std::size_t(*size) * *size > std::size_t(end - begin)) return false;
+
+	cells->resize(std::size_t(*size) * *size);
+
+	for (auto y = 0; y < *size; ++y)
+	{
+		auto line_end = find_line_end(position, end);
+		while (position < end && !is_row(position, line_end))
+		{
+			position = skip_line(line_end, end);
+			line_end = find_line_end(position, end);
+		}
+
+		if (scan_row(position, line_end, cells->data() + std::size_t(y) * *size, *size) != *size) return false;
+		position = skip_line(line_end, end);
+	}
+
+	for (auto number : *cells)
+		if (number > *size) return false;
+
+	return true;
+}
+
+bool parse_sudoku_output(const char* begin, const char* end, std::vector<int>* cells, int* size)
+{
+	cells->clear();
+	*size = 0;
+
+	auto rows = 0;
+	for (auto position = begin; position < end; position = skip_line(position, end))
+	{
+		if (*position != '|') continue;
+
+		const auto line_end = find_line_end(position, end);
+		if (!rows)
+		{
+			*size = scan_row(position, line_end, nullptr, 0);
+
+			const auto n = int(std::lround(std::sqrt(std::max(*size, 0))));
+			if (*size <= 0 || n * n != *size || std::size_t(*size) * *size > std::size_t(end - begin)) return false;
+			cells->resize(std::size_t(*size) * *size);
+		}
+
+		if (scan_row(position, line_end, cells->data() + std::size_t(rows) * *size, *size) != *size) return false;
+		if (++rows == *size) return true;
+	}
+
+	return false;
+}
+
+bool parse_sudoku_line(const char* begin, const char* end, std::vector<int>* cells, int* size)
+{
+	cells->clear();
+
+	if (std::find_if(begin, end, [](const char c) { return c == ' ' || c == '\t'; }) != end)
+	{
+		for (auto position = begin; position < end;)
+		{
+			if (*position == ' ' || *position == '\t' || *position == '\r')
+			{
+				++position;
+				continue;
+			}
+
+			auto number = 0;
+			if (is_digit(*position))
+			{
+				do
+				{
+					number = number * 10 + (*position++ - '0');
+					if (number > 1 << 24) return false;
+				} while (position < end && is_digit(*position));
+			}
+			else if (*position == '_' || *position == '.')
+			{
+				do ++position; while (position < end && (*position == '_' || *position == '.'));
+			}
+			else return false;
+
+			if (position < end && *position != ' ' && *position != '\t' && *position != '\r') return false;
+			cells->push_back(number);
+		}
+	}
+	else
+	{
+		for (auto position = begin; position < end; ++position)
+		{
+			const auto c = *position;
+			if (c == '.' || c == '_' || c == '0') cells->push_back(0);
+			else if (c >= '1' && c <= '9') cells->push_back(c - '0');
+			else if (c >= 'A' && c <= 'Z') cells->push_back(c - 'A' + 10);
+			else if (c >= 'a' && c <= 'z') cells->push_back(c - 'a' + 10);
+			else if (c != '\r') return false;
+		}
+	}
+
+	//cells = size^2 = n^4
+	auto n = 1;
+	while (std::size_t(n) * n * n * n < cells->size()) ++n;
+	if (std::size_t(n) * n * n * n != cells->size()) return false;
+
+	*size = n * n;
+	for (auto number : *cells)
+		if (number > *size) return false;
+
+	return true;
+}
+
+bool parse_sudoku_line(const std::string& line, std::vector<int>* cells, int* size)
+{
+	return parse_sudoku_line(line.data(), line.data() + line.size(), cells, size);
+}
+
+void append_sudoku_line(const int* cells, const int size, std::string* line)
+{
+	const auto count = std::size_t(size) * size;
+
+	if (size <= MAX_COMPACT_SIZE)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			*line += char(cells[i] < 10 ? '0' + cells[i] : 'A' + cells[i] - 10);
+		return;
+	}
+
+	char number[16];
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (i) *line += ' ';
+
+		//digits from the back, without a stream or to_string
+		auto length = 0;
+		auto value = cells[i];
+		do
+		{
+			number[sizeof(number) - ++length] = char('0' + value % 10);
+			value /= 10;
+		} while (value);
+		line->append(number + sizeof(number) - length, length);
+	}
+}
+
+std::string format_sudoku_line(const std::vector<int>& cells, const int size)
+{
+	std::string line;
+	line.reserve(cells.size() * (size <= MAX_COMPACT_SIZE ? 1 : 4));
+	append_sudoku_line(cells.data(), size, &line);
+	return line;
+}
+
+void append_sudoku_grid(const int* cells, const int size, std::string* grid)
+{
+	const auto n = int(std::lround(std::sqrt(size)));
+
+	auto width = 0;
+	for (auto i = 1; i <= size; i *= 10) ++width;
+
+	//every box is "+" and a dash per character of its cells, a row is "| " and the cells of every box, both end with the last border
+	const auto limit_line_length = std::size_t(n) * ((width + 1) * n + 2) + 2;
+	const auto row_length = std::size_t(n) * (2 + (width + 1) * n) + 2;
+
+	auto position = grid->size();
+	grid->resize(position + (n + 1) * limit_line_length + std::size_t(size) * row_length);
+	auto output = &(*grid)[position];
+
+	const auto write_limit_line = [&]() {
+		for (auto box = 0; box < n; ++box)
+		{
+			*output++ = '+';
+			output = std::fill_n(output, (width + 1) * n + 1, '-');
+		}
+		*output++ = '+';
+		*output++ = '\n';
+	};
+
+	for (auto y = 0; y < size; ++y)
+	{
+		if (y % n == 0) write_limit_line();
+
+		const auto row = cells + std::size_t(y) * size;
+		for (auto x = 0; x < size; ++x)
+		{
+			if (x % n == 0)
+			{
+				*output++ = '|';
+				*output++ = ' ';
+			}
+
+			auto number = row[x];
+			if (!number) output = std::fill_n(output, width, '_');
+			else
+			{
+				//digits from the back, padded with spaces in front
+				for (auto i = width - 1; i >= 0; --i)
+				{
+					output[i] = number ? char('0' + number % 10) : ' ';
+					number /= 10;
+				}
+				output += width;
+			}
+			*output++ = ' ';
+		}
+		*output++ = '|';
+		*output++ = '\n';
+	}
+	write_limit_line();
+}
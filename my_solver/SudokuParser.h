@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//reads a sudoku file through a mapping, see parse_sudoku_text()
+bool read_sudoku_file(const std::string& path, std::vector<int>* cells, int* size);
+
+//parses a sudoku in one of the table formats with a single pass over the text, nothing is copied into lines or streams
+//	"experiment:" and three more header lines, the last names the size as "<size>x<size>"
+//	no header, the text starts with the first delimiter line "+---", the size is the amount of cells in the first row
+//	the two header lines of the sudoku reader, always 9x9
+//then come the rows, lines starting with + are delimiters, | separates the boxes and an empty cell is a run of _ or . or a 0
+//cells get the numbers row by row with 0 for an empty cell, returns false if the text is no sudoku
+bool parse_sudoku_text(const char* begin, const char* end, std::vector<int>* cells, int* size);
+
+//reads the grid print() wrote out of the output of a run, lines that don't start with | are ignored
+//the size is the amount of cells in the first row, returns false if there isn't a complete grid of that size
+bool parse_sudoku_output(const char* begin, const char* end, std::vector<int>* cells, int* size);
+
+//reads a sudoku written on a single line, row by row
+//either one character per cell, 1-9 and then A-Z for the numbers and 0, . or _ for an empty cell,
+//or numbers separated by whitespace where an empty cell is 0 or a token of only . or _
+//the amount of cells decides the size, so it has to be n^4, returns false if the line is no sudoku
+bool parse_sudoku_line(const char* begin, const char* end, std::vector<int>* cells, int* size);
+bool parse_sudoku_line(const std::string& line, std::vector<int>* cells, int* size);
+
+//writes the cells in the format of parse_sudoku_line(), single characters while 1-9 and A-Z suffice (up to 25x25), numbers separated by spaces above
+void append_sudoku_line(const int* cells, int size, std::string* line);
+std::string format_sudoku_line(const std::vector<int>& cells, int size);
+
+//renders the cells in the table format read by parse_sudoku_text(), without header, in one pass into the buffer
+//numbers are right aligned to the width of the size, empty cells (0) are a run of _ of that width
+void append_sudoku_grid(const int* cells, int size, std::string* grid);
@@ -0,0 +1,141 @@
+#include "pch.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+
+std::atomic<bool> trace_enabled(false);
+static std::atomic<bool> trace_discarded(false);
+
+struct TraceEvent
+{
+	const char* name;
+	const char* category;
+	std::int64_t start;
+	std::int64_t end;
+	std::int64_t value;
+	CounterValues counters;
+};
+
+//the ring of one thread, the mutex is only contended while the events are written
+struct TraceBuffer
+{
+	std::mutex mutex;
+	std::vector<TraceEvent> events;
+	std::size_t next = 0;			//where the next event goes once the ring is full
+	int thread = 0;
+};
+
+//never freed, the buffers are written by an atexit handler after the static objects might be gone
+static std::mutex* buffers_mutex = new std::mutex;
+static std::vector<std::unique_ptr<TraceBuffer>>* buffers = new std::vector<std::unique_ptr<TraceBuffer>>;
+static std::string* trace_path = new std::string;
+
+static thread_local TraceBuffer* local_buffer = nullptr;
+
+static TraceBuffer* get_local_buffer()
+{
+	if (local_buffer) return local_buffer;
+
+	std::lock_guard<std::mutex> lock(*buffers_mutex);
+	buffers->emplace_back(new TraceBuffer);
+	local_buffer = buffers->back().get();
+	local_buffer->thread = int(buffers->size());
+	return local_buffer;
+}
+
+static void write_trace_at_exit()
+{
+	if (trace_discarded.load()) return;
+	if (!write_trace(*trace_path)) std::cerr << "Couldn't write the trace \"" << *trace_path << "\"." << std::endl;
+}
+
+void enable_trace(const std::string& path)
+{
+	if (!trace_enabled.exchange(true)) std::atexit(write_trace_at_exit);
+	*trace_path = path;
+}
+
+void discard_trace()
+{
+	trace_discarded = true;
+}
+
+std::int64_t get_trace_time()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void add_trace_event(const char* name, const char* category, const std::int64_t start, const std::int64_t end, const std::int64_t value,
+					 const CounterValues* counters)
+{
+	const TraceEvent event{name, category, start, end, value, counters ? *counters : CounterValues()};
+
+	auto buffer = get_local_buffer();
+	std::lock_guard<std::mutex> lock(buffer->mutex);
+
+	if (buffer->events.size() < TRACE_BUFFER_EVENTS)
+	{
+		buffer->events.push_back(event);
+		return;
+	}
+
+	buffer->events[buffer->next] = event;
+	buffer->next = (buffer->next + 1) % TRACE_BUFFER_EVENTS;
+}
+
+bool write_trace(const std::string& path)
+{
+	std::ofstream file(path);
+	if (!file.is_open()) return false;
+
+	std::lock_guard<std::mutex> lock(*buffers_mutex);
+
+	//the times start at the first event, chrome wants microseconds
+	auto origin = get_trace_time();
+	for (const auto& buffer : *buffers)
+	{
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+		for (const auto& event : buffer->events) origin = std::min(origin, event.start);
+	}
+
+	const auto pid = getpid();
+	file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	file << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":\"Sudoku\"}}";
+
+	for (const auto& buffer : *buffers)
+	{
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+		//the oldest event of a full ring is the one that is overwritten next
+		const auto count = buffer->events.size();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const auto& event = buffer->events[(buffer->next + i) % count];
+			file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":"
+				 << (event.start - origin) / 1e3 << ",\"dur\":" << (event.end - event.start) / 1e3
+				 << ",\"pid\":" << pid << ",\"tid\":" << buffer->thread;
+
+			//the value and the counters are the arguments of the event
+			std::string arguments;
+			if (event.value != -1) arguments += ",\"value\":" + std::to_string(event.value);
+			for (auto counter = 0; counter < HARDWARE_COUNTER_COUNT; ++counter)
+			{
+				const auto counted = event.counters.get(HardwareCounter(counter));
+				if (counted != -1) arguments += ",\"" + get_hardware_counter_name(HardwareCounter(counter)) + "\":" + std::to_string(counted);
+			}
+			if (!arguments.empty()) file << ",\"args\":{" << arguments.substr(1) << "}";
+			file << "}";
+		}
+	}
+
+	file << "\n]}\n";
+	return bool(file);
+}
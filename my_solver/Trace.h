@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "PerfCounters.h"
+
+//events of a run written as chrome trace json when the process exits, to be opened in chrome://tracing or perfetto
+//tracing is off until enable_trace() is called, a disabled event only checks a flag, an enabled one reads the clock twice
+//and stores into a ring buffer of its thread, so a thread keeps its latest TRACE_BUFFER_EVENTS events
+const int TRACE_BUFFER_EVENTS = 1 << 16;
+
+extern std::atomic<bool> trace_enabled;
+
+//the events are written to the path on a normal exit
+void enable_trace(const std::string& path);
+
+//skips the write on exit, for signal_handler(): the signal may have interrupted a thread that holds the lock of its buffer
+//only sets a lock free flag, so it is safe to call from a signal handler
+void discard_trace();
+
+//nanoseconds of the steady clock, the times of add_trace_event()
+std::int64_t get_trace_time();
+
+//records an event that already ended, the names have to be string literals since only the pointers are kept
+//a value of -1 isn't written, otherwise it's shown as the argument of the event, like the counters if they are given
+void add_trace_event(const char* name, const char* category, std::int64_t start, std::int64_t end, std::int64_t value = -1,
+					 const CounterValues* counters = nullptr);
+
+//writes the events of all threads, returns false if the file can't be written
+bool write_trace(const std::string& path);
+
+//records an event from its construction to its destruction
+//a phase, the event of the category "phase", also records the hardware counters of its thread if they are enabled
+class ScopedTrace
+{
+public:
+	explicit ScopedTrace(const char* name) : ScopedTrace(name, "phase")
+	{
+		if (mStart != -1) mCounted = read_counters(&mCounters);
+	}
+
+	ScopedTrace(const char* name, const char* category, const std::int64_t value = -1) :
+		mName(name), mCategory(category), mValue(value), mStart(trace_enabled.load(std::memory_order_relaxed) ? get_trace_time() : -1)
+	{
+	}
+
+	~ScopedTrace()
+	{
+		if (mStart == -1) return;
+
+		CounterValues end;
+		if (mCounted && read_counters(&end))
+		{
+			const auto counted = get_counter_difference(mCounters, end);
+			add_trace_event(mName, mCategory, mStart, get_trace_time(), mValue, &counted);
+		}
+		else add_trace_event(mName, mCategory, mStart, get_trace_time(), mValue);
+	}
+
+	ScopedTrace(const ScopedTrace&) = delete;
+	ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+	//the value is only known at the end, like the number of clauses of a family
+	void set_value(const std::int64_t value) { mValue = value; }
+
+private:
+	const char* mName;
+	const char* mCategory;
+	std::int64_t mValue;
+	std::int64_t mStart;		//-1 if tracing is off
+	bool mCounted = false;
+	CounterValues mCounters;	//at the start
+};
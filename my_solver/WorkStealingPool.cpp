@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(const int threads) : mThreads(threads > 0 ? threads : 1), mQueues(mThreads), mSteals(mThreads, 0)
+{
+}
+
+void WorkStealingPool::add(std::function<void()> task)
+{
+	mQueues[mNext_queue].tasks.push_back(std::move(task));
+	mNext_queue = (mNext_queue + 1) % mThreads;
+}
+
+void WorkStealingPool::run()
+{
+	std::fill(mSteals.begin(), mSteals.end(), 0);
+
+	std::vector<std::thread> workers;
+	for (auto worker = 0; worker < mThreads; ++worker)
+	{
+		workers.emplace_back([this, worker]() {
+			std::function<void()> task;
+			while (take(worker, &task)) task();
+		});
+	}
+
+	for (auto& worker : workers) worker.join();
+}
+
+const std::vector<int>& WorkStealingPool::get_steals() const
+{
+	return mSteals;
+}
+
+bool WorkStealingPool::take(const int worker, std::function<void()>* task)
+{
+	{
+		auto& own = mQueues[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			*task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	//nothing left in the own queue, steal the oldest task of the next one that has work
+	//no tasks are added while running, so once every queue was empty there's nothing left to do
+	for (auto i = 1; i < mThreads; ++i)
+	{
+		auto& victim = mQueues[(worker + i) % mThreads];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			*task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			++mSteals[worker];
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+//runs a fixed list of tasks on several threads
+//every worker owns a queue and takes tasks from its back, a worker without tasks steals from the front of another queue,
+//so a worker stuck on one hard sudoku doesn't keep the rest of its queue waiting
+class WorkStealingPool
+{
+public:
+	explicit WorkStealingPool(int threads);
+
+	//queues a task, the tasks are spread round robin over the workers, only valid before run()
+	void add(std::function<void()> task);
+
+	//runs all queued tasks and returns once they are finished
+	void run();
+
+	//amount of tasks every worker took from another queue during the last run()
+	const std::vector<int>& get_steals() const;
+
+private:
+	//takes the next task for the worker, returns false if every queue is empty
+	bool take(int worker, std::function<void()>* task);
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	int mThreads;
+	int mNext_queue = 0;
+
+	std::vector<Queue> mQueues;
+	std::vector<int> mSteals;
+};